@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "bench.h"
+
+typedef struct _bench_cpu_t bench_cpu_t;
+struct _bench_cpu_t {
+  char model[128];
+  char governor[32]; // "unknown", if there is no cpufreq
+  double cur_mhz; // 0: unknown
+  double min_mhz;
+  double max_mhz;
+};
+
+typedef struct _bench_stat_t bench_stat_t;
+struct _bench_stat_t {
+  double median; // ms per timestep
+  double min;
+  double p95;
+  double mean;
+  double stddev;
+};
+
+static double bench_read_khz( const char * file ) {
+  double khz = 0.0;
+  FILE * f = fopen( file, "r" );
+  if( f != NULL ) {
+    if( fscanf( f, "%lf", &khz ) != 1 )
+      khz = 0.0;
+    fclose( f );
+  }
+  return khz;
+}
+
+// cpufreq of cpu0, /proc/cpuinfo otherwise (e.g. within VMs)
+static void bench_cpu( bench_cpu_t * cpu ) {
+  strcpy( cpu->model, "unknown" );
+  strcpy( cpu->governor, "unknown" );
+  cpu->cur_mhz = bench_read_khz( "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq" ) / 1000.0;
+  cpu->min_mhz = bench_read_khz( "/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_min_freq" ) / 1000.0;
+  cpu->max_mhz = bench_read_khz( "/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq" ) / 1000.0;
+
+  FILE * f = fopen( "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", "r" );
+  if( f != NULL ) {
+    if( fscanf( f, "%31s", cpu->governor ) != 1 )
+      strcpy( cpu->governor, "unknown" );
+    fclose( f );
+  }
+
+  f = fopen( "/proc/cpuinfo", "r" );
+  if( f != NULL ) {
+    char line[256];
+    int model = 0, mhz = cpu->cur_mhz > 0.0;
+    while( (! model || ! mhz) && fgets( line, sizeof(line), f ) ) {
+      char * v = strchr( line, ':' );
+      if( v == NULL )
+        continue;
+      v += 2;
+      v[ strcspn( v, "\n" ) ] = '\0';
+      if( ! model && ! strncmp( line, "model name", 10 ) ) {
+        strncpy( cpu->model, v, sizeof(cpu->model) - 1 );
+        cpu->model[ sizeof(cpu->model) - 1 ] = '\0';
+        model = 1;
+      }
+      else if( ! mhz && ! strncmp( line, "cpu MHz", 7 ) ) {
+        cpu->cur_mhz = atof( v );
+        mhz = 1;
+      }
+    }
+    fclose( f );
+  }
+}
+
+// as done by seismic_run(): thread i on core i % cores
+static const char * bench_pinning( unsigned threads ) {
+  return threads > get_num_cores() ? "compact-oversubscribed" : "compact";
+}
+
+static int bench_cmp( const void * a, const void * b ) {
+  double x = *(const double*) a, y = *(const double*) b;
+  return x < y ? -1 : x > y;
+}
+
+// sorts the samples
+static void bench_stat( double * ms, unsigned n, bench_stat_t * st ) {
+  qsort( ms, n, sizeof(double), bench_cmp );
+  st->min = ms[ 0 ];
+  st->median = n & 0x1 ? ms[ n / 2 ] : (ms[ n / 2 - 1 ] + ms[ n / 2 ]) / 2.0;
+  st->p95 = ms[ (unsigned)ceil( 0.95 * n ) - 1 ]; // nearest rank
+
+  unsigned i;
+  st->mean = 0.0;
+  for( i = 0; i < n; i++ )
+    st->mean += ms[ i ];
+  st->mean /= n;
+  st->stddev = 0.0;
+  for( i = 0; n > 1 && i < n; i++ )
+    st->stddev += (ms[ i ] - st->mean) * (ms[ i ] - st->mean);
+  st->stddev = n > 1 ? sqrt( st->stddev / (n - 1) ) : 0.0;
+}
+
+// runs steps timesteps of kernel k, returns ms per timestep
+static double bench_once( config_t * config, unsigned k, unsigned steps, stack_t * data, BARRIER_TYPE * barrier,
+                          float * APF, float * NPPF, float * VEL, float * pulsevector ) {
+  // every run from the same (zero) state, no denormals left by the one before
+  unsigned long len = (unsigned long)config->width * config->depth * config->height * sizeof(float);
+  memset( APF, 0, len );
+  memset( NPPF, 0, len );
+
+  config->variant = config->bench_variant[ k ];
+  seismic_setup( config, data, barrier, APF, NPPF, VEL, pulsevector );
+
+  unsigned t_id;
+  for( t_id = 0; t_id < config->threads; t_id++ )
+    data[t_id].timesteps = steps;
+
+  seismic_run( config, data, config->threads == 1 ? config->variant->fnc_sgl : config->variant->fnc_par );
+
+  // like INNER: the time loop of thread 0
+  return ((data[0].e.tv_sec - data[0].s.tv_sec) * 1000.0 + (data[0].e.tv_usec - data[0].s.tv_usec) / 1000.0) / steps;
+}
+
+// src as the contents of a JSON string, dst of 6 * strlen( src ) + 1 at most
+static void bench_json( char * dst, const char * src ) {
+  for( ; *src; src++ ) {
+    if( *src == '"' || *src == '\\' ) {
+      *dst++ = '\\';
+      *dst++ = *src;
+    }
+    else if( (unsigned char)*src < 0x20 )
+      dst += sprintf( dst, "\\u%04x", (unsigned char)*src );
+    else
+      *dst++ = *src;
+  }
+  *dst = '\0';
+}
+
+// the line of a kernel in the baseline, without the GFLOPS
+static void bench_key( char * key, unsigned len, config_t * config, const char * model, unsigned k ) {
+  snprintf( key, len, "%s\t%s\t%ux%ux%u\t%u\t%u\t", model, config->bench_variant[ k ]->name,
+            config->width, config->height, config->depth, config->threads, config->timesteps );
+}
+
+/*
+  records (update) or checks the median GFLOPS of every kernel, one line
+  per CPU model, kernel and setup. Kernels without a line pass with a
+  warning, so a new machine needs an update first. Returns the number of
+  regressions, missing the number of kernels without a line.
+*/
+static unsigned bench_baseline( config_t * config, const char * model, const double * gflops, unsigned * missing ) {
+  unsigned n = config->bench_c, k, l, lines_c = 0, failed = 0;
+  char ** lines = (char**) malloc( 0x1000 * sizeof(char*) );
+  char key[ 512 ], line[ sizeof(key) + 32 ]; // key and the GFLOPS
+  if( lines == NULL ) {
+    printf("allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  FILE * f = fopen( config->baseline, "r" );
+  if( f == NULL && ! config->update ) {
+    fprintf(stderr, "ERROR: could not open baseline '%s'\n", config->baseline);
+    exit(EXIT_FAILURE);
+  }
+  while( f != NULL && lines_c < 0x1000 && fgets( line, sizeof(line), f ) ) {
+    if( (lines[ lines_c ] = strdup( line )) == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+    lines_c++;
+  }
+  if( f != NULL )
+    fclose( f );
+
+  for( k = 0; k < n; k++ ) {
+    const char * name = config->bench_variant[ k ]->name;
+    bench_key( key, sizeof(key), config, model, k );
+    for( l = 0; l < lines_c && strncmp( lines[ l ], key, strlen( key ) ); l++ );
+
+    if( config->update ) {
+      snprintf( line, sizeof(line), "%s%.3f\n", key, gflops[ k ] );
+      if( l == lines_c ) {
+        if( lines_c == 0x1000 ) {
+          fprintf(stderr, "ERROR: baseline '%s' is full\n", config->baseline);
+          exit(EXIT_FAILURE);
+        }
+        lines_c++;
+      }
+      else
+        free( lines[ l ] );
+      if( (lines[ l ] = strdup( line )) == NULL ) {
+        printf("allocation failure\n");
+        exit(EXIT_FAILURE);
+      }
+      printf("baseline %-32s %8.2f GFLOPS\n", name, gflops[ k ]);
+    }
+    else if( l == lines_c ) {
+      printf("WARNING: no baseline of %s for this CPU and setup, see --update-baseline\n", name);
+      (*missing)++;
+    }
+    else {
+      double base = atof( lines[ l ] + strlen( key ) );
+      int ok = gflops[ k ] >= base * (1.0 - config->tolerance / 100.0);
+      printf("baseline %-32s %8.2f GFLOPS (baseline %8.2f, %+6.1f%%) %s\n", name, gflops[ k ], base,
+             base > 0.0 ? 100.0 * (gflops[ k ] / base - 1.0) : 0.0, ok ? "ok" : "FAIL");
+      failed += ! ok;
+    }
+  }
+
+  if( config->update ) {
+    if( (f = fopen( config->baseline, "w" )) == NULL ) {
+      fprintf(stderr, "ERROR: could not create '%s'\n", config->baseline);
+      exit(EXIT_FAILURE);
+    }
+    for( l = 0; l < lines_c; l++ )
+      fputs( lines[ l ], f );
+    fclose( f );
+    printf("baseline -> %s\n", config->baseline);
+  }
+
+  for( l = 0; l < lines_c; l++ )
+    free( lines[ l ] );
+  free( lines );
+  return failed;
+}
+
+void bench_run( config_t * config, stack_t * data, BARRIER_TYPE * barrier, float * APF, float * NPPF, float * VEL, float * pulsevector,
+                const roofline_t * roof ) {
+  unsigned n = config->bench_c, reps = config->bench, steps = config->timesteps;
+  unsigned warmup = config->warmup;
+  double points = (double)(config->width - 4) * (config->height - 4) * (config->depth > 1 ? config->depth - 4 : 1);
+  double flop = points * config->variant->flops + 1.0; // per timestep, see get_config()
+  double bytes = points * config->variant->bytes;
+  sym_kernel_t * variant = config->variant;
+
+  double * ms = (double*) malloc( (unsigned long)n * reps * sizeof(double) );
+  bench_stat_t * st = (bench_stat_t*) malloc( n * sizeof(bench_stat_t) );
+  if( ms == NULL || st == NULL ) {
+    printf("allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  bench_cpu_t cpu;
+  bench_cpu( &cpu );
+  double mhz_start = cpu.cur_mhz;
+
+  unsigned k, r;
+  for( k = 0; k < n; k++ ) {
+    if(config->verbose)
+      printf("warmup %s, %u timesteps ", config->bench_variant[ k ]->name, warmup);
+    bench_once( config, k, warmup, data, barrier, APF, NPPF, VEL, pulsevector );
+    if(config->verbose)
+      printf("\n");
+  }
+  for( r = 0; r < reps; r++ ) {
+    if(config->verbose)
+      printf("repetition %u of %u ", r + 1, reps);
+    for( k = 0; k < n; k++ )
+      ms[ k * reps + r ] = bench_once( config, k, steps, data, barrier, APF, NPPF, VEL, pulsevector );
+    if(config->verbose)
+      printf("\n");
+  }
+
+  bench_cpu( &cpu ); // the frequency after the load
+  config->variant = variant;
+
+  // the raw samples for the report, before bench_stat() sorts them
+  FILE * f = strcmp( config->bfile, "-" ) ? fopen( config->bfile, "w" ) : stdout;
+  if( f == NULL ) {
+    fprintf(stderr, "ERROR: could not create '%s'\n", config->bfile);
+    exit(EXIT_FAILURE);
+  }
+  char model[ 6 * sizeof(cpu.model) ];
+  bench_json( model, cpu.model );
+  const char * ext = strrchr( config->bfile, '.' );
+  int csv = ext != NULL && ! strcmp( ext, ".csv" );
+
+  if( csv )
+    fprintf( f, "kernel,median_ms,min_ms,p95_ms,mean_ms,stddev_ms,gflops_median,gflops_best,gbs_median,gbs_best,"
+                "width,height,depth,threads,pinning,steps,warmup,repetitions,governor,mhz_start,mhz_end,roof_gflops,roof_pct\n" );
+  else
+    fprintf( f, "{\n"
+                "  \"grid\": { \"width\": %u, \"height\": %u, \"depth\": %u, \"threads\": %u, \"pinning\": \"%s\" },\n"
+                "  \"run\": { \"steps\": %u, \"warmup\": %u, \"repetitions\": %u },\n"
+                "  \"cpu\": { \"model\": \"%s\", \"cores\": %u, \"governor\": \"%s\", \"mhz_start\": %.1f, \"mhz_end\": %.1f, \"mhz_min\": %.1f, \"mhz_max\": %.1f },\n"
+                "  \"model\": { \"flop_per_step\": %.0f, \"bytes_per_step\": %.0f },\n",
+             config->width, config->height, config->depth, config->threads, bench_pinning( config->threads ), steps, warmup, reps,
+             model, get_num_cores(), cpu.governor, mhz_start, cpu.cur_mhz, cpu.min_mhz, cpu.max_mhz, flop, bytes );
+  if( ! csv && roof ) {
+    unsigned p;
+    fprintf( f, "  \"roofline\": { \"copy_gbs\": %.3f, \"triad_gbs\": %.3f, \"peak_gflops\": [", roof->copy, roof->triad );
+    for( p = 0; p < ROOFLINE_PEAKS; p++ )
+      fprintf( f, "%s%.3f", p ? ", " : " ", roof->peak[ p ] );
+    fprintf( f, " ] },\n" );
+  }
+  if( ! csv )
+    fprintf( f, "  \"kernels\": [\n" );
+
+  for( k = 0; k < n; k++ ) {
+    double * s = &ms[ k * reps ];
+    if( ! csv ) {
+      fprintf( f, "    { \"name\": \"%s\", \"samples_ms\": [", config->bench_variant[ k ]->name );
+      for( r = 0; r < reps; r++ )
+        fprintf( f, "%s%.6f", r ? ", " : " ", s[ r ] );
+      fprintf( f, " ],\n" );
+    }
+
+    bench_stat( s, reps, &st[ k ] );
+    double gflops = flop / st[ k ].median / 1e6, gflops_best = flop / st[ k ].min / 1e6;
+    double gbs = bytes / st[ k ].median / 1e6, gbs_best = bytes / st[ k ].min / 1e6;
+    double bound = roof ? roofline_bound( roof, config->bench_variant[ k ] ) : 0.0;
+    if( csv ) {
+      fprintf( f, "%s,%.6f,%.6f,%.6f,%.6f,%.6f,%.3f,%.3f,%.3f,%.3f,%u,%u,%u,%u,%s,%u,%u,%u,%s,%.1f,%.1f,",
+               config->bench_variant[ k ]->name, st[ k ].median, st[ k ].min, st[ k ].p95, st[ k ].mean, st[ k ].stddev,
+               gflops, gflops_best, gbs, gbs_best, config->width, config->height, config->depth, config->threads,
+               bench_pinning( config->threads ), steps, warmup, reps, cpu.governor, mhz_start, cpu.cur_mhz );
+      if( roof )
+        fprintf( f, "%.3f,%.2f", bound, 100.0 * gflops / bound );
+      fprintf( f, "\n" );
+    }
+    else {
+      fprintf( f, "      \"step_ms\": { \"median\": %.6f, \"min\": %.6f, \"p95\": %.6f, \"mean\": %.6f, \"stddev\": %.6f },\n"
+                  "      \"gflops\": { \"median\": %.3f, \"best\": %.3f },\n"
+                  "      \"gbs\": { \"median\": %.3f, \"best\": %.3f }",
+               st[ k ].median, st[ k ].min, st[ k ].p95, st[ k ].mean, st[ k ].stddev,
+               gflops, gflops_best, gbs, gbs_best );
+      if( roof )
+        fprintf( f, ",\n      \"roofline\": { \"intensity\": %.4f, \"bound_gflops\": %.3f, \"percent\": %.2f }",
+                 (double)config->bench_variant[ k ]->flops / config->bench_variant[ k ]->bytes, bound, 100.0 * gflops / bound );
+      fprintf( f, " }%s\n", k + 1 < n ? "," : "" );
+    }
+  }
+  if( ! csv )
+    fprintf( f, "  ]\n}\n" );
+  if( f != stdout )
+    fclose( f );
+
+  // summary, relative to the slowest kernel
+  double slowest = 0.0;
+  for( k = 0; k < n; k++ )
+    if( st[ k ].median > slowest )
+      slowest = st[ k ].median;
+
+  printf("\n%-32s %10s %10s %10s %8s %8s %8s %8s\n", "kernel (ms/step)", "median", "min", "p95", "stddev", "GFLOPS", "GB/s", "speedup");
+  for( k = 0; k < n; k++ )
+    printf("%-32s %10.4f %10.4f %10.4f %7.2f%% %8.2f %8.2f %7.2fx\n", config->bench_variant[ k ]->name,
+           st[ k ].median, st[ k ].min, st[ k ].p95, 100.0 * st[ k ].stddev / st[ k ].mean,
+           flop / st[ k ].median / 1e6, bytes / st[ k ].median / 1e6, slowest / st[ k ].median );
+  for( k = 0; roof && k < n; k++ )
+    roofline_kernel( roof, config->bench_variant[ k ], flop / st[ k ].median / 1e6 );
+  printf("CPU: %s, governor %s, %.0f -> %.0f MHz\n", cpu.model, cpu.governor, mhz_start, cpu.cur_mhz);
+  if( strcmp( cpu.governor, "performance" ) && strcmp( cpu.governor, "unknown" ) )
+    printf("WARNING: governor '%s', the frequency may change during the benchmark\n", cpu.governor);
+  if( strcmp( config->bfile, "-" ) )
+    printf("report -> %s\n", config->bfile);
+
+  unsigned failed = 0, missing = 0;
+  if( config->baseline ) {
+    double * gflops = (double*) malloc( n * sizeof(double) );
+    if( gflops == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+    for( k = 0; k < n; k++ )
+      gflops[ k ] = flop / st[ k ].median / 1e6;
+    failed = bench_baseline( config, cpu.model, gflops, &missing );
+    free( gflops );
+  }
+
+  free( ms );
+  free( st );
+
+  if( failed ) {
+    fprintf(stderr, "ERROR: %u kernel(s) more than %u%% below the baseline\n", failed, config->tolerance);
+    exit(EXIT_FAILURE);
+  }
+  if( missing == n ) {
+    printf("no baseline of %s for this CPU and setup, nothing checked\n", config->baseline);
+    exit(BENCH_NO_BASELINE);
+  }
+}
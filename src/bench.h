@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "config.h"
+#include "kernel.h"
+#include "roofline.h"
+
+/*
+  Benchmark mode (--bench): all selected kernels run in this process on
+  the same matrices. After 'warmup' timesteps per kernel, the kernels take
+  turns for 'bench' repetitions of 'timesteps' each (round robin, so that
+  throttling and turbo hit all of them alike). Each repetition gives one
+  sample of the time per timestep; the report holds median, min, p95 and
+  stddev of those, GFLOPS and the effective bandwidth, plus the CPU model,
+  governor and frequency.
+
+  The bandwidth counts what a timestep has to move at least, the bytes
+  per point of the kernel (see KERNEL_BYTES).
+
+  With --baseline the median GFLOPS of each kernel are checked against a
+  text file, one tab-separated line per CPU model, kernel, grid, threads
+  and timesteps; a loss beyond --tolerance percent fails the run. Without
+  a line for any of the kernels the run exits with BENCH_NO_BASELINE
+  (ctest: skipped). --update-baseline records the results there instead.
+*/
+
+#define BENCH_NO_BASELINE 77 // exit code, nothing to check against
+
+// roof: the roofline of each kernel too, NULL: none
+void bench_run( config_t * config, stack_t * data, BARRIER_TYPE * barrier, float * APF, float * NPPF, float * VEL, float * pulsevector,
+                const roofline_t * roof );
+
+// main.c
+void seismic_run( config_t * config, stack_t * data, void (* func)(void *) );
+void seismic_setup( config_t * config, stack_t * data, BARRIER_TYPE * barrier, float * APF, float * NPPF, float * VEL, float * pulsevector );
+
+#endif /* #ifndef _BENCH_H_ */
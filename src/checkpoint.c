@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/time.h>
+#include "checkpoint.h"
+#include "trace.h"
+
+static int checkpoint_write( int fd, const void * buf, unsigned long len ) {
+  const char * p = (const char*) buf;
+  while( len ) {
+    ssize_t n = write( fd, p, len );
+    if( n <= 0 )
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+static void * checkpoint_writer( void * v ) {
+  checkpoint_t * ckpt = (checkpoint_t*) v;
+  struct timespec nap = { 0, 50000 };
+  unsigned long frame = (unsigned long)ckpt->width * ckpt->height * sizeof(float);
+  unsigned n, tr = TRACE_THREAD( "checkpoint writer" );
+
+  for( n = ckpt->first; n <= ckpt->last; n++ ) {
+    while( __atomic_load_n( &ckpt->filled, __ATOMIC_ACQUIRE ) != ckpt->threads )
+      nanosleep( &nap, NULL );
+    TRACE_START( tr );
+
+    // the previous checkpoint stays intact until the new one is complete
+    ckpt->hdr.step = n * ckpt->every;
+    int fd = open( ckpt->tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 || checkpoint_write( fd, &ckpt->hdr, sizeof(ckpt->hdr) )
+        || checkpoint_write( fd, ckpt->buf, 2 * frame )
+        || fsync( fd ) || close( fd ) || rename( ckpt->tmp, ckpt->file ) ) {
+      fprintf(stderr, "ERROR: could not write checkpoint '%s' of timestep %u\n", ckpt->file, ckpt->hdr.step);
+      exit(EXIT_FAILURE);
+    }
+    ckpt->saved++;
+    ckpt->written += sizeof(ckpt->hdr) + 2 * frame;
+    TRACE_MARK( tr, TRACE_WRITE, n * ckpt->every );
+
+    // hand the buffer back, for checkpoint n + 1
+    __atomic_store_n( &ckpt->filled, 0, __ATOMIC_RELAXED );
+    __atomic_store_n( &ckpt->next, n + 1, __ATOMIC_RELEASE );
+  }
+  return NULL;
+}
+
+// start: timestep the run starts from, checkpoints are taken after it and before the last one
+checkpoint_t * checkpoint_create( const char * file, const checkpoint_header_t * hdr, unsigned every, unsigned start, unsigned threads ) {
+  checkpoint_t * ckpt = (checkpoint_t*) calloc( 1, sizeof(checkpoint_t) );
+  if( ckpt == NULL )
+    return NULL;
+
+  ckpt->file = file;
+  ckpt->width = hdr->width;
+  ckpt->height = hdr->height;
+  ckpt->threads = threads;
+  ckpt->every = every;
+  ckpt->first = start / every + 1;
+  ckpt->last = hdr->timesteps ? (hdr->timesteps - 1) / every : 0;
+  ckpt->hdr = *hdr;
+  ckpt->next = ckpt->first;
+
+  ckpt->tmp = (char*) malloc( strlen( file ) + sizeof(".tmp") );
+  ckpt->buf = (float*) malloc( (unsigned long)ckpt->width * ckpt->height * 2 * sizeof(float) );
+  ckpt->stall = (double*) calloc( threads, sizeof(double) );
+  if( ckpt->tmp == NULL || ckpt->buf == NULL || ckpt->stall == NULL ) {
+    checkpoint_destroy( ckpt );
+    return NULL;
+  }
+  sprintf( ckpt->tmp, "%s.tmp", file );
+
+  if( pthread_create( &ckpt->writer, NULL, checkpoint_writer, ckpt ) ) {
+    printf("ERROR: Couldn't create the checkpoint writer thread!!\nExiting...\n");
+    exit( EXIT_FAILURE );
+  }
+  return ckpt;
+}
+
+void checkpoint_put( checkpoint_t * ckpt, unsigned step, unsigned id, unsigned x_start, unsigned x_end, const float * apf, const float * nppf ) {
+  unsigned n = step / ckpt->every;
+  if( n < ckpt->first || n > ckpt->last )
+    return;
+
+  // only waits, if the writer still holds checkpoint n - 1
+  if( __atomic_load_n( &ckpt->next, __ATOMIC_ACQUIRE ) != n ) {
+    struct timeval w1, w2;
+    gettimeofday(&w1, NULL);
+    while( __atomic_load_n( &ckpt->next, __ATOMIC_ACQUIRE ) != n )
+      sched_yield();
+    gettimeofday(&w2, NULL);
+    ckpt->stall[ id ] += (w2.tv_sec - w1.tv_sec) * 1000.0 + (w2.tv_usec - w1.tv_usec) / 1000.0;
+  }
+
+  unsigned long off = (unsigned long)x_start * ckpt->height, len = (unsigned long)(x_end - x_start) * ckpt->height * sizeof(float);
+  memcpy( &ckpt->buf[ off ], &apf[ off ], len );
+  memcpy( &ckpt->buf[ (unsigned long)ckpt->width * ckpt->height + off ], &nppf[ off ], len );
+
+  // the last strip completes the checkpoint
+  __atomic_add_fetch( &ckpt->filled, 1, __ATOMIC_RELEASE );
+}
+
+void checkpoint_wait( checkpoint_t * ckpt ) {
+  if( pthread_join( ckpt->writer, NULL ) ) {
+    printf("ERROR: Couldn't join the checkpoint writer thread!!\nExiting...\n");
+    exit( EXIT_FAILURE );
+  }
+}
+
+void checkpoint_destroy( checkpoint_t * ckpt ) {
+  free( ckpt->tmp );
+  free( ckpt->buf );
+  free( ckpt->stall );
+  free( ckpt );
+}
+
+int checkpoint_load( const char * file, const checkpoint_header_t * hdr, float * apf, float * nppf ) {
+  FILE * f = fopen( file, "rb" );
+  if( f == NULL ) {
+    fprintf(stderr, "ERROR: could not open checkpoint '%s'\n", file);
+    return -1;
+  }
+
+  checkpoint_header_t saved;
+  if( fread( &saved, sizeof(saved), 1, f ) != 1
+      || memcmp( saved.magic, CHECKPOINT_MAGIC, sizeof(saved.magic) ) || saved.version != CHECKPOINT_VERSION ) {
+    fprintf(stderr, "ERROR: '%s' is no checkpoint\n", file);
+    fclose( f );
+    return -1;
+  }
+
+  // anything else would silently change the result
+  const char * differs = saved.width != hdr->width || saved.height != hdr->height ? "grid"
+                       : saved.timesteps != hdr->timesteps ? "timesteps"
+                       : saved.pulseX != hdr->pulseX || saved.pulseY != hdr->pulseY ? "pulse"
+                       : saved.randbound != hdr->randbound ? "randbound"
+                       : saved.model_x0 != hdr->model_x0 ? "aperture"
+                       : saved.encode != hdr->encode ? "encode"
+                       : strncmp( saved.kernel, hdr->kernel, sizeof(saved.kernel) ) ? "kernel"
+                       : strncmp( saved.velocity, hdr->velocity, sizeof(saved.velocity) ) ? "velocity"
+                       : strncmp( saved.inject, hdr->inject, sizeof(saved.inject) ) ? "inject"
+                       : strncmp( saved.sources, hdr->sources, sizeof(saved.sources) ) ? "sources"
+                       : saved.step > hdr->timesteps ? "step" : NULL;
+  if( differs ) {
+    fprintf(stderr, "ERROR: checkpoint '%s' differs in %s from this run\n", file, differs);
+    fclose( f );
+    return -1;
+  }
+
+  unsigned long len = (unsigned long)saved.width * saved.height;
+  if( fread( apf, sizeof(float), len, f ) != len || fread( nppf, sizeof(float), len, f ) != len ) {
+    fprintf(stderr, "ERROR: checkpoint '%s' is truncated\n", file);
+    fclose( f );
+    return -1;
+  }
+
+  fclose( f );
+  return saved.step;
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include <stdint.h>
+#include <pthread.h>
+
+/*
+  Checkpoints of a propagation, native byte order:
+
+    header | apf (width x height) | nppf (width x height)
+
+  apf is the frame after timestep 'step' (incl. the pulse for the next
+  one), nppf the one before; the rest of the header is the configuration
+  a restart has to match for a bit-identical result.
+
+  Every 'every'-th timestep the compute threads copy their own strips of
+  both frames into a single snapshot buffer and carry on; a writer thread
+  writes it into file.tmp and renames that over the file, so that the
+  file always holds a complete checkpoint. A compute thread only waits if
+  the previous checkpoint is still being written.
+*/
+
+#define CHECKPOINT_MAGIC    "SRTMCKPT"
+#define CHECKPOINT_VERSION  1
+
+typedef struct _checkpoint_header_t checkpoint_header_t;
+struct _checkpoint_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t step; // timesteps done
+
+  uint32_t width; // grid
+  uint32_t height;
+  uint32_t timesteps;
+  uint32_t pulseX;
+  uint32_t pulseY;
+  uint32_t randbound;
+  uint32_t model_x0;
+  uint32_t encode;
+  char kernel[32];
+  char velocity[256]; // file names as given, "" for none
+  char inject[256];
+  char sources[256];
+};
+
+typedef struct _checkpoint_t checkpoint_t;
+struct _checkpoint_t {
+  const char * file;
+  char * tmp; // file.tmp
+  unsigned width;
+  unsigned height;
+  unsigned threads; // strips per checkpoint
+  unsigned every;
+  unsigned first; // checkpoints step / every of [first, last]
+  unsigned last;
+  checkpoint_header_t hdr;
+
+  float * buf; // apf, then nppf
+  unsigned filled; // strips copied, atomic
+  unsigned next; // checkpoint the buffer takes next, atomic
+
+  pthread_t writer;
+  unsigned saved; // statistics
+  unsigned long written; // bytes
+  double * stall; // ms, per compute thread
+};
+
+// hdr: configuration to save, its step is set per checkpoint
+checkpoint_t * checkpoint_create( const char * file, const checkpoint_header_t * hdr, unsigned every, unsigned start, unsigned threads );
+void checkpoint_put( checkpoint_t * ckpt, unsigned step, unsigned id, unsigned x_start, unsigned x_end, const float * apf, const float * nppf );
+void checkpoint_wait( checkpoint_t * ckpt );
+void checkpoint_destroy( checkpoint_t * ckpt );
+
+// checks hdr against the saved one, returns the step or -1
+int checkpoint_load( const char * file, const checkpoint_header_t * hdr, float * apf, float * nppf );
+
+#endif /* #ifndef _CHECKPOINT_H_ */
@@ -11,9 +11,14 @@
 #include <stdio.h>          /* for printf */
 #include <stdlib.h>         /* for atoi */
 #include <string.h>         /* for strcmp */
+#include <limits.h>         /* for UINT_MAX */
 #include "config.h"
 #include "check_hw.h"
 #include "kernel.h"
+#include "snapfile.h"
+#include "shmring.h"
+#include "roofline.h"
+#include "trace.h"
 
 #define elemsof( x )        (sizeof( (x) ) / sizeof( (x)[0] ))
 
@@ -23,17 +28,62 @@ sym_kernel_t* sym_kern[32];
 void default_values( config_t * config ) {
   config->width     = 2300;
   config->height    = 748;
+  config->depth     = 1;
   config->timesteps = 100;
   config->pulseY    = config->height / 2;
   config->pulseX    = config->width / 2;
+  config->pulseZ    = 0;
   config->variant   = sym_kern[0];
+  unsigned i;
+  for( i = 0; i < sym_kern_c; i++ ) // 2D by default
+    if( sym_kern[i]->dims == 2 ) {
+      config->variant = sym_kern[i];
+      break;
+    }
   config->threads   = 1;
   config->clopt     = 0;
+  config->randbound = 0;
+  config->aperture  = 0;
+  config->reverse   = 0;
+  config->reverse_error = 1e-2f;
+  config->cpml      = 0;
+  config->velocity  = NULL;
+  config->keep      = 0;
+  config->compress  = 0.0f;
+  config->every     = 0;
+  config->mfile     = "movie.bin";
+  config->ckpt_every = 0;
+  config->cfile     = "checkpoint.bin";
+  config->restart   = NULL;
+  config->shm_every = 0;
+  config->shm       = "/seismic-rtm";
+  config->receivers = NULL;
+  config->subsample = 1;
+  config->tfile     = "gather.su";
+  config->inject    = NULL;
+  config->sources   = NULL;
+  config->encode    = 0;
+  config->track     = 0;
+  config->ooc       = NULL;
+  config->ooc_cols  = 1024;
+  config->ooc_steps = 8;
 
   config->output    = 0;
   config->ofile     = "output.bin";
+  config->mapped    = 0;
   config->ascii     = 0; // will also be used for scale!
   config->verbose   = 1;
+  config->perf      = 0;
+  config->imbalance = 0;
+  config->roofline  = 0;
+  config->timeline  = NULL;
+  config->bench     = 0;
+  config->warmup    = 0;
+  config->bfile     = "bench.json";
+  config->bench_c   = 0;
+  config->baseline  = NULL;
+  config->tolerance = 10;
+  config->update    = 0;
 }
 
 void print_usage( const char * argv0 ) {
@@ -51,28 +101,156 @@ void print_usage( const char * argv0 ) {
          "  \t y coordinate of pulse offset.\n"
          "  --pulseX \t( -j )                    Default: %u\n"
          "  \t x coordinate of pulse offset.\n"
+         "  --depth \t( -D )                    Default: %u\n"
+         "  \t Define matrix size along z, 3D if larger than 1.\n"
+         "  --pulseZ \t( -Z )                    Default: depth / 2\n"
+         "  \t z coordinate of pulse offset.\n"
          "  --timesteps \t( -t )                    Default: %u\n"
          "  \t Determine number of timesteps.\n"
-         "  --kernel \t( -k )                    Default: %s\n",
-          argv0, c.height, c.width, c.pulseY, c.pulseX, c.timesteps, sym_kern[0]->name );
+         "  --kernel \t( -k )                    Default: %s\n"
+         "  \t A comma-separated list for --bench, all by default.\n",
+          argv0, c.height, c.width, c.pulseY, c.pulseX, c.depth, c.timesteps, c.variant->name );
 
   archfeatures cap = check_hw_capabilites();
   unsigned i;
   for( i = 0; i < sym_kern_c; i++ )
     if( ! (sym_kern[i]->cap.bits & ~cap.bits) )
-      printf("  \t %s\n", sym_kern[i]->name );
+      printf("  \t %s%s\n", sym_kern[i]->name, sym_kern[i]->dims == 3 ? " (3D)" : "" );
 
   printf("  --threads \t( -p )                    Default: %u\n"
          "  \t Number of threads.\n"
          "  --output \t( -o )                    Default: \"output.bin\"\n"
          "  \t Write output to file 'file'.\n"
+         "  \t A snapshot container for *.snap (seismic-snap.elf).\n"
+         "  --map-output\t( -P )\n"
+         "  \t Propagate in shared mappings of the output, which\n"
+         "  \t saves writing the final frame at the end.\n"
          "  --ascii\t( -a ) <scale>            Default: %u\n"
          "  \t Print an ascii image.\n"
          "  \t Parameter will be used as scale.\n"
+         "  --velocity\t( -v ) <file>\n"
+         "  \t Velocity model (m/s), one column of height values per x.\n"
+         "  \t Raw float32, SU (*.su) or SEG-Y (*.sgy, *.segy).\n"
+         "  --randbound\t( -b ) <points>          Default: %u\n"
+         "  \t Pad the model with a layer of random velocities.\n"
+         "  --aperture\t( -m ) <points>          Default: %u (whole model)\n"
+         "  \t Propagate only the columns within this distance of\n"
+         "  \t pulse or sources and of the receivers.\n"
+         "  --reverse\t( -r ) [<error>]        Default: %g\n"
+         "  \t Recompute the source wavefield backwards in time.\n"
+         "  \t Output and ascii show the reconstructed first frame.\n"
+         "  \t Fails beyond this error relative to the pulse.\n"
+         "  --cpml\t( -l ) <points>          Default: %u\n"
+         "  \t Absorb at the edges within a layer of this thickness.\n"
+         "  --keep\t( -e ) <steps>           Default: %u\n"
+         "  \t Keep every n-th frame compressed in memory.\n"
+         "  --compress\t( -z ) <lossless|error>  Default: lossless\n"
+         "  \t Compression of kept frames, error bounds the\n"
+         "  \t absolute deviation of each value.\n"
+         "  --snapshot-every\t( -S ) <steps>     Default: %u\n"
+         "  \t Write every n-th frame into the movie, 0: none.\n"
+         "  --movie\t( -M ) <file>            Default: \"%s\"\n"
+         "  \t Raw float32 frames of the whole grid or, for\n"
+         "  \t *.snap, an indexed snapshot container.\n"
+         "  --checkpoint-every\t( -K ) <steps>   Default: %u\n"
+         "  \t Save a checkpoint every n-th timestep, 0: none.\n"
+         "  --checkpoint\t( -C ) <file>          Default: \"%s\"\n"
+         "  \t Both frames, timestep and configuration.\n"
+         "  --restart\t( -R ) <file>\n"
+         "  \t Continue from a checkpoint, same options otherwise.\n"
+         "  --shm-every\t( -E ) <steps>          Default: %u\n"
+         "  \t Publish every n-th frame into shared memory, 0: none.\n"
+         "  --shm\t( -H ) <name>            Default: \"%s\"\n"
+         "  \t Ring of the last frames for live consumers.\n"
+         "  --receivers\t( -g ) <x0:x1:dx@y|file>\n"
+         "  \t Record traces at a line of receivers or at the\n"
+         "  \t 'x y' points listed in file.\n"
+         "  --subsample\t( -u ) <steps>           Default: %u\n"
+         "  \t Record every n-th timestep only.\n"
+         "  --traces\t( -w ) <file>            Default: \"%s\"\n"
+         "  \t Write traces as SU, or SEG-Y for *.sgy / *.segy.\n"
+         "  --inject\t( -n ) <file>\n"
+         "  \t Inject the traces of a SU / SEG-Y file backwards\n"
+         "  \t in time instead of the pulse (backward propagation).\n"
+         "  --sources\t( -s ) <x0:x1:dx@y|file>\n"
+         "  \t Fire the pulse at a line of sources or at the\n"
+         "  \t 'x y [delay [polarity]]' points listed in file.\n"
+         "  --encode\t( -d ) <seed>            Default: %u\n"
+         "  \t Random polarities of the sources, 0: none.\n"
+         "  --track\t( -f )\n"
+         "  \t Skip the columns the wavefield has not reached yet.\n"
+         "  \t Threads keep their strips, i.e. the ones not reached\n"
+         "  \t yet are idle.\n"
+         "  --outofcore\t( -O ) <dir>\n"
+         "  \t Keep the matrices in files of dir, stream them\n"
+         "  \t through the memory in blocks of columns.\n"
+         "  --oocblock\t( -B ) <cols>x<steps>     Default: %ux%u\n"
+         "  \t Columns per block and timesteps per pass.\n"
+         "  --perf\t( -X ) [uncore]\n"
+         "  \t Count cycles, instructions and cache misses per\n"
+         "  \t thread, with uncore the memory traffic as well.\n"
+         "  --imbalance\t( -I )\n"
+         "  \t Time compute and barrier wait of every thread and\n"
+         "  \t timestep, show the load imbalance at the end.\n"
+         "  --timeline\t( -Y ) <file>\n"
+         "  \t Kernel, barrier, hook and I/O slices of every thread\n"
+         "  \t as Chrome trace JSON (Perfetto), needs a build with\n"
+         "  \t -DSEISMIC_TRACE=ON.\n"
+         "  --roofline\t( -L )\n"
+         "  \t Measure stream bandwidth and multiply-add peaks first,\n"
+         "  \t rate the kernel(s) against this roofline.\n"
+         "  --bench\t( -A ) [<reps>]         Default: 10\n"
+         "  \t Benchmark the kernels instead of a propagation:\n"
+         "  \t time reps runs of timesteps each per kernel.\n"
+         "  --warmup\t( -W ) <steps>           Default: timesteps / 10\n"
+         "  \t Timesteps per kernel before the benchmark.\n"
+         "  --report\t( -J ) <file>            Default: \"%s\"\n"
+         "  \t Results as JSON, or CSV for *.csv, '-': stdout.\n"
+         "  --baseline\t( -G ) <file>\n"
+         "  \t Fail, if the median GFLOPS of a kernel fall below\n"
+         "  \t the ones recorded for this CPU model and setup.\n"
+         "  --tolerance\t( -T ) <percent>       Default: %u\n"
+         "  \t Loss against the baseline that still passes.\n"
+         "  --update-baseline\t( -U )\n"
+         "  \t Record the results in the baseline instead.\n"
          "  --quite\t( -q)\n"
          "  \t Run without verbose output.\n"
          "  --help \t( -h )\n"
-         "  \t Show this help page.\n", c.threads, c.ascii );
+         "  \t Show this help page.\n", c.threads, c.ascii, c.randbound, c.aperture, c.reverse_error, c.cpml, c.keep, c.every, c.mfile, c.ckpt_every, c.cfile, c.shm_every, c.shm, c.subsample, c.tfile, c.encode, c.ooc_cols, c.ooc_steps, c.bfile, c.tolerance );
+}
+
+// x range of a line "x0:x1:dx@y" or of a file with x first per line
+static void spec_span( const char * spec, unsigned * lo, unsigned * hi ) {
+  unsigned x0, x1, dx, y;
+  char c;
+
+  if( spec == NULL )
+    return;
+
+  if( sscanf( spec, "%u:%u:%u@%u%c", &x0, &x1, &dx, &y, &c ) == 4 ) {
+    if( x0 < *lo )
+      *lo = x0;
+    if( x1 > *hi )
+      *hi = x1;
+    return;
+  }
+
+  FILE * f = fopen( spec, "r" );
+  if( f == NULL )
+    return; // reported once the points are read
+  char line[256];
+  while( fgets( line, sizeof(line), f ) ) {
+    char * p = strchr( line, '#' );
+    if( p )
+      *p = '\0';
+    if( sscanf( line, "%u", &x0 ) != 1 )
+      continue;
+    if( x0 < *lo )
+      *lo = x0;
+    if( x0 > *hi )
+      *hi = x0;
+  }
+  fclose( f );
 }
 
 unsigned long round_and_get_unit( unsigned long mem, char * type ) {
@@ -107,12 +285,48 @@ void get_config( int argc, char * argv[], config_t * config ) {
     {"width",       required_argument,  NULL,           'y'},
     {"pulseY",      required_argument,  NULL,           'i'},
     {"pulseX",      required_argument,  NULL,           'j'},
+    {"depth",       required_argument,  NULL,           'D'},
+    {"pulseZ",      required_argument,  NULL,           'Z'},
     {"timesteps",   required_argument,  NULL,           't'},
     {"kernel",      required_argument,  NULL,           'k'},
     {"threads",     required_argument,  NULL,           'p'},
     {"clopt",       no_argument,        NULL,           'c'},
     {"output",      optional_argument,  NULL,           'o'},
+    {"map-output",  no_argument,        NULL,           'P'},
     {"ascii",       required_argument,  NULL,           'a'},
+    {"velocity",    required_argument,  NULL,           'v'},
+    {"randbound",   required_argument,  NULL,           'b'},
+    {"aperture",    required_argument,  NULL,           'm'},
+    {"reverse",     optional_argument,  NULL,           'r'},
+    {"cpml",        required_argument,  NULL,           'l'},
+    {"keep",        required_argument,  NULL,           'e'},
+    {"compress",    required_argument,  NULL,           'z'},
+    {"snapshot-every", required_argument, NULL,         'S'},
+    {"movie",       required_argument,  NULL,           'M'},
+    {"checkpoint-every", required_argument, NULL,       'K'},
+    {"checkpoint",  required_argument,  NULL,           'C'},
+    {"restart",     required_argument,  NULL,           'R'},
+    {"shm-every",   required_argument,  NULL,           'E'},
+    {"shm",         required_argument,  NULL,           'H'},
+    {"receivers",   required_argument,  NULL,           'g'},
+    {"subsample",   required_argument,  NULL,           'u'},
+    {"traces",      required_argument,  NULL,           'w'},
+    {"inject",      required_argument,  NULL,           'n'},
+    {"sources",     required_argument,  NULL,           's'},
+    {"encode",      required_argument,  NULL,           'd'},
+    {"track",       no_argument,        NULL,           'f'},
+    {"outofcore",   required_argument,  NULL,           'O'},
+    {"oocblock",    required_argument,  NULL,           'B'},
+    {"perf",        optional_argument,  NULL,           'X'},
+    {"imbalance",   no_argument,        NULL,           'I'},
+    {"timeline",    required_argument,  NULL,           'Y'},
+    {"roofline",    no_argument,        NULL,           'L'},
+    {"bench",       optional_argument,  NULL,           'A'},
+    {"warmup",      required_argument,  NULL,           'W'},
+    {"report",      required_argument,  NULL,           'J'},
+    {"baseline",    required_argument,  NULL,           'G'},
+    {"tolerance",   required_argument,  NULL,           'T'},
+    {"update-baseline", no_argument,    NULL,           'U'},
     {"help",        no_argument,        NULL,           'h'},
     {"quite",       no_argument,        NULL,           'q'},
 
@@ -120,9 +334,10 @@ void get_config( int argc, char * argv[], config_t * config ) {
   };
 
   archfeatures cap = check_hw_capabilites();
+  unsigned kernel = 0, pulseZ = 0; // given?
   while( 1 ) {
     int option_index = 0;
-    int opt = getopt_long( argc, argv, "x:y:i:j:t:k:p:co::a:hq", long_options, &option_index );
+    int opt = getopt_long( argc, argv, "x:y:i:j:D:Z:t:k:p:co::Pa:v:b:m:r::l:e:z:S:M:K:C:R:E:H:g:u:w:n:s:d:fO:B:X::IY:LA::W:J:G:T:Uhq", long_options, &option_index );
     if( opt == -1 )
       break;
 
@@ -143,27 +358,46 @@ void get_config( int argc, char * argv[], config_t * config ) {
         config->pulseX = atoi( optarg );
         break;
 
+      case 'D':
+        config->depth = atoi( optarg );
+        break;
+
+      case 'Z':
+        config->pulseZ = atoi( optarg );
+        pulseZ = 1;
+        break;
+
       case 't':
         config->timesteps = atoi( optarg );
         break;
 
       case 'k':
         {
-          unsigned i, found = 0;
-          for( i = 0; i < sym_kern_c; i++ ) {
-            if( ! strcmp( optarg, sym_kern[i]->name )
-                && (cap.bits & sym_kern[i]->cap.bits) == sym_kern[i]->cap.bits ) {
-              config->variant = sym_kern[i];
-              found = 1;
-              break;
+          // one or a comma-separated list, the first one runs without --bench
+          const char * name = optarg;
+          kernel = 1;
+          config->bench_c = 0;
+          while( 1 ) {
+            unsigned i, found = 0, len = strcspn( name, "," );
+            for( i = 0; i < sym_kern_c; i++ ) {
+              if( ! strncmp( name, sym_kern[i]->name, len ) && ! sym_kern[i]->name[ len ]
+                  && (cap.bits & sym_kern[i]->cap.bits) == sym_kern[i]->cap.bits ) {
+                found = 1;
+                break;
+              }
             }
-          }
 
-          if( ! found ) {
-            fprintf(stderr, "ERROR:\n\tNo supported version given! '%s' \n\n", optarg );
-            print_usage( argv[0] );
-            exit(EXIT_FAILURE);
+            if( ! found || config->bench_c == elemsof(config->bench_variant) ) {
+              fprintf(stderr, "ERROR:\n\tNo supported version given! '%.*s' \n\n", (int)len, name );
+              print_usage( argv[0] );
+              exit(EXIT_FAILURE);
+            }
+            config->bench_variant[ config->bench_c++ ] = sym_kern[i];
+            if( ! name[ len ] )
+              break;
+            name += len + 1;
           }
+          config->variant = config->bench_variant[ 0 ];
         }
         break;
 
@@ -181,10 +415,172 @@ void get_config( int argc, char * argv[], config_t * config ) {
           config->ofile = optarg;
         break;
 
+      case 'P':
+        config->mapped = 1;
+        break;
+
       case 'a':
         config->ascii = atoi(optarg);
         break;
 
+      case 'v':
+        config->velocity = optarg;
+        break;
+
+      case 'b':
+        config->randbound = atoi(optarg);
+        break;
+
+      case 'm':
+        config->aperture = atoi(optarg);
+        break;
+
+      case 'r':
+        config->reverse = 1;
+        if( optarg && (config->reverse_error = atof(optarg)) <= 0.0f ) {
+          fprintf(stderr, "ERROR: reverse needs a positive error\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+
+      case 'l':
+        config->cpml = atoi(optarg);
+        break;
+
+      case 'e':
+        config->keep = atoi(optarg);
+        break;
+
+      case 'z':
+        if( ! strcmp( "lossless", optarg ) )
+          config->compress = 0.0f;
+        else
+          config->compress = atof(optarg);
+        break;
+
+      case 'S':
+        config->every = atoi(optarg);
+        break;
+
+      case 'M':
+        config->mfile = optarg;
+        break;
+
+      case 'K':
+        config->ckpt_every = atoi(optarg);
+        break;
+
+      case 'C':
+        config->cfile = optarg;
+        break;
+
+      case 'R':
+        config->restart = optarg;
+        break;
+
+      case 'E':
+        config->shm_every = atoi(optarg);
+        break;
+
+      case 'H':
+        config->shm = optarg;
+        break;
+
+      case 'g':
+        config->receivers = optarg;
+        break;
+
+      case 'u':
+        config->subsample = atoi(optarg);
+        break;
+
+      case 'w':
+        config->tfile = optarg;
+        break;
+
+      case 'n':
+        config->inject = optarg;
+        break;
+
+      case 's':
+        config->sources = optarg;
+        break;
+
+      case 'd':
+        config->encode = atoi(optarg);
+        break;
+
+      case 'f':
+        config->track = 1;
+        break;
+
+      case 'O':
+        config->ooc = optarg;
+        break;
+
+      case 'B':
+        if( sscanf( optarg, "%ux%u", &config->ooc_cols, &config->ooc_steps ) != 2 ) {
+          fprintf(stderr, "ERROR: oocblock needs <cols>x<steps>, not '%s'\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+
+      case 'X':
+        if( optarg && strcmp( optarg, "uncore" ) ) {
+          fprintf(stderr, "ERROR: perf knows 'uncore' only, not '%s'\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        config->perf = optarg ? 2 : 1;
+        break;
+
+      case 'I':
+        config->imbalance = 1;
+        break;
+
+      case 'Y':
+#ifndef SEISMIC_TRACE
+        fprintf(stderr, "ERROR: timeline needs a build with -DSEISMIC_TRACE=ON\n");
+        exit(EXIT_FAILURE);
+#endif
+        config->timeline = optarg;
+        break;
+
+      case 'L':
+        config->roofline = 1;
+        break;
+
+      case 'A':
+        config->bench = optarg ? atoi(optarg) : 10;
+        if( ! config->bench ) {
+          fprintf(stderr, "ERROR: bench needs at least 1 repetition\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+
+      case 'W':
+        config->warmup = atoi(optarg);
+        break;
+
+      case 'J':
+        config->bfile = optarg;
+        break;
+
+      case 'G':
+        config->baseline = optarg;
+        break;
+
+      case 'T':
+        config->tolerance = atoi(optarg);
+        if( config->tolerance >= 100 ) {
+          fprintf(stderr, "ERROR: tolerance has to be below 100 percent\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+
+      case 'U':
+        config->update = 1;
+        break;
+
       case 'q':
         config->verbose = 0;
         break;
@@ -211,13 +607,6 @@ void get_config( int argc, char * argv[], config_t * config ) {
     exit(EXIT_FAILURE);
   }
 
-// validation checks!
-  if( (config->variant->vectorwidth || config->threads)
-      && ((config->height - 4) * sizeof(float)) % (config->variant->vectorwidth * config->threads) ) {
-    fprintf(stderr, "ERROR: the height needs to be: (X * simd * threads) + 4!\n");
-    exit(EXIT_FAILURE);
-  }
-
   if( config->pulseX > config->width ) {
     fprintf(stderr, "ERROR: pulseX (%u) is larger then width (%u)!\n", config->pulseX, config->width);
     exit(EXIT_FAILURE);
@@ -231,7 +620,289 @@ void get_config( int argc, char * argv[], config_t * config ) {
   if( ! config->threads )
     config->threads = 1;
 
-  config->GFLOP = (((double)(config->width - 4) * (double)(config->height - 4) * 15.0 + 1.0) * (double)config->timesteps)/1000000.0;
+  if( ! config->depth )
+    config->depth = 1;
+  if( config->depth > 1 ) {
+    // the same strips, hooks and files as 2D are not there (yet)
+    const char * twod = config->clopt ? "clopt" : config->randbound ? "randbound" : config->reverse ? "reverse"
+                      : config->cpml ? "cpml" : config->velocity ? "velocity" : config->keep ? "keep" : config->every ? "snapshot-every"
+                      : config->receivers ? "receivers" : config->inject ? "inject" : config->sources ? "sources"
+                      : config->track ? "track" : config->aperture ? "aperture" : config->ooc ? "outofcore"
+                      : config->ckpt_every ? "checkpoint-every" : config->restart ? "restart" : config->shm_every ? "shm-every"
+                      : config->output && snapfile_is( config->ofile ) ? "output to *.snap" : NULL;
+    if( twod ) {
+      fprintf(stderr, "ERROR: %s is 2D only\n", twod);
+      exit(EXIT_FAILURE);
+    }
+
+    if( config->depth <= 4 ) {
+      fprintf(stderr, "ERROR: depth needs to be larger than 4\n");
+      exit(EXIT_FAILURE);
+    }
+    if( ! pulseZ )
+      config->pulseZ = config->depth / 2;
+    if( config->pulseZ >= config->depth ) {
+      fprintf(stderr, "ERROR: pulseZ (%u) is larger then depth (%u)!\n", config->pulseZ, config->depth);
+      exit(EXIT_FAILURE);
+    }
+
+    if( ! kernel ) {
+      unsigned i;
+      for( i = 0; i < sym_kern_c; i++ )
+        if( sym_kern[i]->dims == 3 ) {
+          config->variant = sym_kern[i];
+          break;
+        }
+    }
+  }
+  else
+    config->pulseZ = 0;
+
+  if( config->bench_c > 1 && ! config->bench ) {
+    fprintf(stderr, "ERROR: several kernels need --bench\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( (config->baseline || config->update) && ! config->bench ) {
+    fprintf(stderr, "ERROR: baseline needs --bench\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->update && ! config->baseline ) {
+    fprintf(stderr, "ERROR: update-baseline needs --baseline\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->bench ) {
+    // the time loop alone, no hooks and no files
+    const char * other = config->clopt ? "clopt" : config->reverse ? "reverse" : config->cpml ? "cpml"
+                       : config->keep ? "keep" : config->every ? "snapshot-every" : config->receivers ? "receivers"
+                       : config->inject ? "inject" : config->sources ? "sources" : config->track ? "track"
+                       : config->ooc ? "outofcore" : config->ckpt_every ? "checkpoint-every" : config->restart ? "restart"
+                       : config->shm_every ? "shm-every" : config->mapped ? "map-output" : config->output ? "output"
+                       : config->ascii ? "ascii" : config->perf ? "perf" : config->imbalance ? "imbalance"
+                       : config->timeline ? "timeline" : NULL;
+    if( other ) {
+      fprintf(stderr, "ERROR: %s is not part of --bench\n", other);
+      exit(EXIT_FAILURE);
+    }
+
+    // all the machine supports
+    if( ! kernel ) {
+      unsigned i;
+      for( i = 0; i < sym_kern_c; i++ )
+        if( sym_kern[i]->dims == (config->depth > 1 ? 3 : 2) && ! (sym_kern[i]->cap.bits & ~cap.bits) )
+          config->bench_variant[ config->bench_c++ ] = sym_kern[i];
+    }
+
+    // allocated for the largest alignment
+    unsigned k;
+    for( k = 0; k < config->bench_c; k++ ) {
+      if( config->bench_variant[ k ]->dims != (config->depth > 1 ? 3 : 2) ) {
+        fprintf(stderr, "ERROR: kernel '%s' is not for %uD, see --depth\n", config->bench_variant[ k ]->name, config->depth > 1 ? 3 : 2);
+        exit(EXIT_FAILURE);
+      }
+      if( ! k || config->bench_variant[ k ]->alignment > config->variant->alignment )
+        config->variant = config->bench_variant[ k ];
+    }
+  }
+
+  if( config->variant->dims != (config->depth > 1 ? 3 : 2) ) {
+    fprintf(stderr, "ERROR: kernel '%s' is not for %uD, see --depth\n", config->variant->name, config->depth > 1 ? 3 : 2);
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->reverse && config->timesteps < 2 ) {
+    fprintf(stderr, "ERROR: reverse needs at least 2 timesteps\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->cpml && config->clopt ) {
+    fprintf(stderr, "ERROR: cpml needs whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->cpml && config->reverse ) {
+    fprintf(stderr, "ERROR: cpml absorbs, hence is not time-reversible, no reverse\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->keep && config->clopt ) {
+    fprintf(stderr, "ERROR: keep needs whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->every && config->clopt ) {
+    fprintf(stderr, "ERROR: snapshot-every needs whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->ckpt_every && config->clopt ) {
+    fprintf(stderr, "ERROR: checkpoint-every needs whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->shm_every && config->clopt ) {
+    fprintf(stderr, "ERROR: shm-every needs whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // one object, no directories
+  if( config->shm_every && (config->shm[ 0 ] != '/' || strchr( config->shm + 1, '/' ) || ! config->shm[ 1 ]) ) {
+    fprintf(stderr, "ERROR: shm needs a name like /name\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // the state of these is not part of a checkpoint
+  if( config->ckpt_every || config->restart ) {
+    const char * stateful = config->cpml ? "cpml" : config->restart && config->keep ? "keep"
+                          : config->restart && config->every ? "snapshot-every"
+                          : config->restart && config->receivers ? "receivers" : NULL;
+    if( stateful ) {
+      fprintf(stderr, "ERROR: %s is not supported with %s\n", stateful, config->restart ? "restart" : "checkpoint-every");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if( config->receivers && config->clopt ) {
+    fprintf(stderr, "ERROR: receivers need whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->inject && config->clopt ) {
+    fprintf(stderr, "ERROR: inject needs whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->inject && config->reverse ) {
+    fprintf(stderr, "ERROR: inject has no pulse to reconstruct, no reverse\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->sources && config->clopt ) {
+    fprintf(stderr, "ERROR: sources need whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->sources && (config->reverse || config->inject) ) {
+    fprintf(stderr, "ERROR: sources replace the pulse, no reverse or inject\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->track && config->clopt ) {
+    fprintf(stderr, "ERROR: track needs whole strips per thread, no clopt\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->ooc ) {
+    // blocks only know the pulse, no other hooks or interleaved strips
+    const char * inmem = config->clopt ? "clopt" : config->reverse ? "reverse" : config->cpml ? "cpml"
+                       : config->keep ? "keep" : config->every ? "snapshot-every" : config->receivers ? "receivers" : config->inject ? "inject"
+                       : config->sources ? "sources" : config->track ? "track"
+                       : config->ckpt_every ? "checkpoint-every" : config->restart ? "restart"
+                       : config->shm_every ? "shm-every" : config->perf ? "perf" : config->imbalance ? "imbalance" : NULL;
+    if( inmem ) {
+      fprintf(stderr, "ERROR: %s is not supported out-of-core\n", inmem);
+      exit(EXIT_FAILURE);
+    }
+
+    // even, so that every block starts with the alignment of column 0
+    if( config->ooc_cols < 8 || (config->ooc_cols & 0x1) || config->ooc_cols < 4 * config->threads ) {
+      fprintf(stderr, "ERROR: oocblock needs an even number of at least 8 and 4 * threads columns\n");
+      exit(EXIT_FAILURE);
+    }
+    if( ! config->ooc_steps ) {
+      fprintf(stderr, "ERROR: oocblock needs at least 1 timestep per pass\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if( config->mapped ) {
+    // the output has to be the grid as is, from the first element on
+    const char * copied = ! config->output ? "no output" : config->randbound ? "randbound" : config->aperture ? "aperture"
+                        : config->ooc ? "outofcore" : snapfile_is( config->ofile ) ? "output to *.snap"
+                        : config->variant->alignment ? "an aligned kernel" : NULL;
+    if( copied ) {
+      fprintf(stderr, "ERROR: map-output does not work with %s\n", copied);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if( ! config->subsample )
+    config->subsample = 1;
+
+  if( config->compress < 0.0f ) {
+    fprintf(stderr, "ERROR: compress needs a positive error\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // only the columns around the shot, coordinates stay the ones of the model
+  config->model_x0 = 0;
+  config->survey_width = config->width;
+  if( config->aperture ) {
+    unsigned lo = UINT_MAX, hi = 0;
+    spec_span( config->sources, &lo, &hi );
+    if( lo > hi ) // no sources, the pulse fires
+      lo = hi = config->pulseX;
+    spec_span( config->receivers, &lo, &hi );
+
+    config->model_x0 = lo > config->aperture ? lo - config->aperture : 0;
+    hi = hi + config->aperture + 1 < config->width ? hi + config->aperture + 1 : config->width;
+    config->width = hi - config->model_x0;
+    if( config->width <= 4 ) {
+      fprintf(stderr, "ERROR: aperture (%u) leaves no more than 4 columns\n", config->aperture);
+      exit(EXIT_FAILURE);
+    }
+
+    // with sources, the (silent) pulse only has to be somewhere within
+    if( config->pulseX < config->model_x0 )
+      config->pulseX = config->model_x0;
+    if( config->pulseX >= hi )
+      config->pulseX = hi - 1;
+    config->pulseX -= config->model_x0;
+  }
+
+  // the random velocity layer surrounds the model, pulse moves along.
+  config->model_width = config->width;
+  config->model_height = config->height;
+  if( config->randbound ) {
+    config->width += 2 * config->randbound;
+    config->height += 2 * config->randbound;
+    config->pulseX += config->randbound;
+    config->pulseY += config->randbound;
+  }
+
+// validation checks!
+  if( config->cpml && (2 * config->cpml + 4 > config->width || 2 * config->cpml + 4 > config->height) ) {
+    fprintf(stderr, "ERROR: cpml (%u) does not fit twice into the matrix\n", config->cpml);
+    exit(EXIT_FAILURE);
+  }
+
+  if( config->bench && ! config->warmup )
+    config->warmup = config->timesteps / 10 ? config->timesteps / 10 : 1;
+
+  // every kernel of the benchmark runs on the same matrices
+  unsigned k;
+  for( k = 0; k < (config->bench ? config->bench_c : 1); k++ ) {
+    sym_kernel_t * variant = config->bench ? config->bench_variant[ k ] : config->variant;
+    if( config->depth > 1 ) {
+      // threads split along z, then (in whole vectors) along y
+      if( ((config->height - 4) * sizeof(float)) % variant->vectorwidth ) {
+        fprintf(stderr, "ERROR: the height needs to be: (X * simd) + 4!\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if( (variant->vectorwidth || config->threads)
+        && ((config->height - 4) * sizeof(float)) % (variant->vectorwidth * config->threads) ) {
+      fprintf(stderr, "ERROR: the height needs to be: (X * simd * threads) + 4 (incl. 2 * randbound)!\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if( config->depth > 1 )
+    config->GFLOP = (((double)(config->width - 4) * (double)(config->height - 4) * (double)(config->depth - 4) * config->variant->flops + 1.0) * (double)config->timesteps)/1000000.0;
+  else
+    config->GFLOP = (((double)(config->width - 4) * (double)(config->height - 4) * config->variant->flops + 1.0) * (double)config->timesteps)/1000000.0;
 }
 
 void print_config( config_t * config ) {
@@ -240,9 +911,14 @@ void print_config( config_t * config ) {
     return;
 
   unsigned long mem = (unsigned long)config->height
-                      * (unsigned long)(config->width + config->variant->alignment)
+                      * ((unsigned long)config->width * config->depth + config->variant->alignment)
                       * sizeof(float) * 3 /* APF, NPPF, VEL */
                       + (config->timesteps /* +1? */) * sizeof(float) /* pulsevector */;
+  if( config->ooc ) // two slots of a block with its halos
+    mem = (unsigned long)config->height
+          * ((unsigned long)config->ooc_cols + 4 * config->ooc_steps)
+          * sizeof(float) * 3 * 2
+          + (config->timesteps /* +1? */) * sizeof(float);
   char type;
   mem = round_and_get_unit( mem, &type );
 
@@ -253,15 +929,56 @@ void print_config( config_t * config ) {
          "(rank0): pulse  = %ux%u\n"
          "(rank0): kernel = %s\n"
          "(rank0): thrds  = %u\n"
+         "(rank0): bound  = %u (random), %u (cpml)\n"
          "(rank0): mem    = %ld %cB\n"
-         "(rank0): GFLOP  = %.2f\n"
-         "=== Running environment:\n",
+         "(rank0): GFLOP  = %.2f\n",
          config->width, config->height,
          config->timesteps,
          config->pulseX, config->pulseY,
          config->variant->name,
          config->threads,
+         config->randbound, config->cpml,
          mem, type, config->GFLOP );
+  if( config->depth > 1 )
+    printf("(rank0): depth  = %u (pulse at %u)\n", config->depth, config->pulseZ );
+  if( config->aperture )
+    printf("(rank0): apert  = %u..%u of %u\n",
+           config->model_x0, config->model_x0 + config->model_width - 1, config->survey_width );
+  if( config->ooc ) {
+    char dtype;
+    unsigned long disk = round_and_get_unit( (unsigned long)config->height * config->width * sizeof(float) * 5, &dtype );
+    printf("(rank0): ooc    = %u cols x %u steps, %ld %cB in %s\n",
+           config->ooc_cols, config->ooc_steps, disk, dtype, config->ooc );
+  }
+  if( config->ckpt_every )
+    printf("(rank0): ckpt   = every %u steps -> %s\n", config->ckpt_every, config->cfile );
+  if( config->restart )
+    printf("(rank0): restrt = %s\n", config->restart );
+  if( config->mapped )
+    printf("(rank0): output = mapped, %s.0 / %s.1 -> %s\n", config->ofile, config->ofile, config->ofile );
+  if( config->shm_every )
+    printf("(rank0): shm    = every %u steps -> %s (%u slots)\n", config->shm_every, config->shm, SHMRING_SLOTS );
+  if( config->perf )
+    printf("(rank0): perf   = per thread%s\n", config->perf > 1 ? ", uncore" : "" );
+  if( config->roofline )
+    printf("(rank0): roof   = stream %u MB x 3, %u repetitions\n", (unsigned)(ROOFLINE_FLOATS * sizeof(float) >> 20), ROOFLINE_REPS );
+  if( config->imbalance )
+    printf("(rank0): imbal  = compute / wait per thread and timestep\n" );
+  if( config->timeline )
+    printf("(rank0): trace  = %u events per thread -> %s\n", TRACE_EVENTS, config->timeline );
+  if( config->bench ) {
+    unsigned k;
+    printf("(rank0): bench  = %u x %u steps (warmup %u) -> %s\n(rank0): kernls =",
+           config->bench, config->timesteps, config->warmup, config->bfile );
+    for( k = 0; k < config->bench_c; k++ )
+      printf(" %s", config->bench_variant[ k ]->name );
+    printf("\n");
+    if( config->update )
+      printf("(rank0): basel  = update -> %s\n", config->baseline );
+    else if( config->baseline )
+      printf("(rank0): basel  = %s, tolerance %u%%\n", config->baseline, config->tolerance );
+  }
+  printf("=== Running environment:\n");
 
   struct utsname myuts;
   if( ! uname( &myuts ) ) {
@@ -10,19 +10,66 @@ typedef struct _config_t config_t;
 struct _config_t {
   unsigned width; // num. of floats
   unsigned height; // num. of floats
+  unsigned depth; // num. of floats, 1: 2D
   unsigned timesteps;
   unsigned pulseY;
   unsigned pulseX;
+  unsigned pulseZ;
 
   sym_kernel_t* variant;
+  sym_kernel_t* bench_variant[32]; // kernels to compare, see bench.h
+  unsigned bench_c;
 
   unsigned threads;
   unsigned clopt;
 
+  unsigned randbound; // thickness of the random velocity layer
+  unsigned model_width; // without randbound layer
+  unsigned model_height;
+  unsigned aperture; // columns around shot and receivers, 0: whole model
+  unsigned model_x0; // first model column of the grid
+  unsigned survey_width; // columns of the whole model
+  unsigned reverse;
+  float reverse_error; // max. error of the reconstructed pulse, relative
+  unsigned cpml; // thickness of the absorbing layer
+  const char *velocity; // model file, NULL: homogeneous
+
+  unsigned keep; // keep every n-th frame in memory
+  float compress; // max. abs error of kept frames, 0: lossless
+  unsigned every; // write every n-th frame into the movie, 0: none
+  const char *mfile; // raw float32 frames
+  unsigned ckpt_every; // save a checkpoint every n-th timestep, 0: none
+  const char *cfile; // checkpoint
+  const char *restart; // checkpoint to continue from, NULL: timestep 0
+  unsigned shm_every; // publish every n-th frame into shared memory, 0: none
+  const char *shm; // name of the shared-memory ring
+
+  const char *receivers; // line spec or file, NULL: none
+  unsigned subsample; // record every n-th timestep
+  const char *tfile; // SU, or SEG-Y if *.sgy / *.segy
+  const char *inject; // traces to inject time-reversed, NULL: none
+  const char *sources; // several sources firing the pulse, NULL: pulse only
+  unsigned encode; // seed of random polarities, 0: none
+  unsigned track; // update only the columns the wavefield reached
+  const char *ooc; // directory of the out-of-core files, NULL: in memory
+  unsigned ooc_cols; // columns per block
+  unsigned ooc_steps; // timesteps per pass
+
   unsigned output;
+  unsigned mapped; // APF and NPPF are mappings of the output
   const char *ofile;
   unsigned ascii;
   unsigned verbose;
+  unsigned perf; // hardware counters per thread, 2: plus memory controllers
+  unsigned imbalance; // compute and barrier wait per thread and timestep
+  unsigned roofline; // measure the machine, rate the kernel against it
+  const char *timeline; // Chrome trace JSON, NULL: none (needs SEISMIC_TRACE)
+  unsigned bench; // repetitions per kernel, 0: no benchmark
+  unsigned warmup; // timesteps per kernel before, 0: timesteps / 10
+  const char *bfile; // JSON, or CSV if *.csv
+  const char *baseline; // GFLOPS per CPU model and kernel, NULL: none
+  unsigned tolerance; // percent below the baseline, still passing
+  unsigned update; // (re)write the baseline instead of checking it
 
   double GFLOP;
 };
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "cpml.h"
+
+// theoretical reflection coefficient of the layer
+#define CPML_R            1e-3
+
+
+// index of i within the two layers of a dimension, -1 outside
+static inline int cpml_layer( unsigned i, unsigned n, unsigned thick ) {
+  if( i >= 2 && i < 2 + thick )
+    return i - 2;
+  if( i >= n - 2 - thick && i < n - 2 )
+    return thick + i - (n - 2 - thick);
+  return -1;
+}
+
+/*
+  d = d0 * dist^2 and alpha = alpha_max * (1 - dist), where dist goes from
+  1/thick at the inner edge of a layer to 1 at the (fixed) outer boundary.
+*/
+static void cpml_profile( float * a, float * b, unsigned n, unsigned thick, double d0, double alpha_max, double dt ) {
+  unsigned i;
+  for( i = 0; i < n; i++ ) {
+    int l = cpml_layer( i, n, thick );
+    if( l < 0 ) {
+      a[ i ] = b[ i ] = 0.0f;
+      continue;
+    }
+
+    double dist = (double)((unsigned)l < thick ? thick - l : l - thick + 1) / thick;
+    double d = d0 * dist * dist;
+    double alpha = alpha_max * (1.0 - dist);
+    b[ i ] = (float)exp( -(d + alpha) * dt );
+    a[ i ] = (float)(d / (d + alpha) * (b[ i ] - 1.0));
+  }
+}
+
+cpml_t * cpml_create( unsigned width, unsigned height, unsigned thick, float v_max, double h, double dt, double fpeak ) {
+  cpml_t * pml = (cpml_t*) calloc( 1, sizeof(cpml_t) );
+  if( pml == NULL )
+    return NULL;
+
+  pml->width = width;
+  pml->height = height;
+  pml->thick = thick;
+
+  pml->ax = (float*) malloc( width * sizeof(float) );
+  pml->bx = (float*) malloc( width * sizeof(float) );
+  pml->ay = (float*) malloc( height * sizeof(float) );
+  pml->by = (float*) malloc( height * sizeof(float) );
+  pml->psi_x = (float*) calloc( 2 * (unsigned long)thick * height, sizeof(float) );
+  pml->zeta_x = (float*) calloc( 2 * (unsigned long)thick * height, sizeof(float) );
+  pml->psi_y = (float*) calloc( 2 * (unsigned long)thick * width, sizeof(float) );
+  pml->zeta_y = (float*) calloc( 2 * (unsigned long)thick * width, sizeof(float) );
+  pml->zero = (float*) calloc( height, sizeof(float) );
+  if( pml->zero == NULL || pml->ax == NULL || pml->bx == NULL || pml->ay == NULL || pml->by == NULL
+      || pml->psi_x == NULL || pml->zeta_x == NULL || pml->psi_y == NULL || pml->zeta_y == NULL ) {
+    cpml_destroy( pml );
+    return NULL;
+  }
+
+  // fpeak is given per timestep
+  double d0 = 3.0 * v_max * log( 1.0 / CPML_R ) / (2.0 * thick * h);
+  double alpha_max = M_PI * fpeak / dt;
+  cpml_profile( pml->ax, pml->bx, width, thick, d0, alpha_max, dt );
+  cpml_profile( pml->ay, pml->by, height, thick, d0, alpha_max, dt );
+
+  return pml;
+}
+
+// psi of the column x, zeros outside the layers
+static inline const float * cpml_psi_x( const cpml_t * pml, unsigned x ) {
+  int l = cpml_layer( x, pml->width, pml->thick );
+  return l < 0 ? pml->zero : &pml->psi_x[ (unsigned long)l * pml->height ];
+}
+
+#define PSI_Y( pml, psi_col, y ) \
+  ( cpml_layer( (y), (pml)->height, (pml)->thick ) < 0 ? 0.0f \
+    : (psi_col)[ cpml_layer( (y), (pml)->height, (pml)->thick ) ] )
+
+/*
+  p is the frame the kernels read (n), np the one they wrote (n+1).
+  Only the columns [x_start, x_end) are touched. Per column, the layer and
+  its coefficients are looked up once, the rows run without branches.
+*/
+void cpml_apply( cpml_t * pml, unsigned x_start, unsigned x_end, const float * p, float * np, const float * vel ) {
+  unsigned long h = pml->height;
+  unsigned thick = pml->thick, x, y;
+  if( x_start < 2 )
+    x_start = 2;
+  if( x_end > pml->width - 2 )
+    x_end = pml->width - 2;
+
+  // rows of the top and bottom layer
+  unsigned rows[2][2] = { { 2, 2 + thick }, { pml->height - 2 - thick, pml->height - 2 } };
+  unsigned r;
+
+  // psi first, zeta needs its derivative
+  for( x = x_start; x < x_end; x++ ) {
+    const float * c = &p[ x * h ];
+    int lx = cpml_layer( x, pml->width, thick );
+    if( lx >= 0 ) {
+      float * psi = &pml->psi_x[ (unsigned long)lx * h ];
+      const float a = pml->ax[ x ], b = pml->bx[ x ];
+      for( y = 2; y < pml->height - 2; y++ )
+        psi[ y ] = b * psi[ y ]
+                 + a * (c[ y - 2 * h ] - 8.0f * c[ y - h ] + 8.0f * c[ y + h ] - c[ y + 2 * h ]);
+    }
+
+    float * psi = &pml->psi_y[ (unsigned long)x * 2 * thick ];
+    for( r = 0; r < 2; r++ )
+      for( y = rows[r][0]; y < rows[r][1]; y++ ) {
+        unsigned l = cpml_layer( y, pml->height, thick );
+        psi[ l ] = pml->by[ y ] * psi[ l ]
+                 + pml->ay[ y ] * (c[ y - 2 ] - 8.0f * c[ y - 1 ] + 8.0f * c[ y + 1 ] - c[ y + 2 ]);
+      }
+  }
+
+  for( x = x_start; x < x_end; x++ ) {
+    const float * c = &p[ x * h ];
+    float * n = &np[ x * h ];
+    const float * v = &vel[ x * h ];
+    int lx = cpml_layer( x, pml->width, thick );
+    if( lx >= 0 ) {
+      float * zeta = &pml->zeta_x[ (unsigned long)lx * h ];
+      const float * pl2 = cpml_psi_x( pml, x - 2 ), * pl1 = cpml_psi_x( pml, x - 1 );
+      const float * pr1 = cpml_psi_x( pml, x + 1 ), * pr2 = cpml_psi_x( pml, x + 2 );
+      const float a = pml->ax[ x ], b = pml->bx[ x ];
+      for( y = 2; y < pml->height - 2; y++ ) {
+        float dpsi = (pl2[ y ] - 8.0f * pl1[ y ] + 8.0f * pr1[ y ] - pr2[ y ]) / 12.0f;
+        float d2 = -c[ y - 2 * h ] + 16.0f * c[ y - h ] - 30.0f * c[ y ] + 16.0f * c[ y + h ] - c[ y + 2 * h ];
+        zeta[ y ] = b * zeta[ y ] + a * (d2 + dpsi);
+        n[ y ] += v[ y ] * (dpsi + zeta[ y ]);
+      }
+    }
+
+    const float * psi = &pml->psi_y[ (unsigned long)x * 2 * thick ];
+    float * zeta = &pml->zeta_y[ (unsigned long)x * 2 * thick ];
+    for( r = 0; r < 2; r++ )
+      for( y = rows[r][0]; y < rows[r][1]; y++ ) {
+        unsigned l = cpml_layer( y, pml->height, thick );
+        float dpsi = (PSI_Y( pml, psi, y - 2 ) - 8.0f * PSI_Y( pml, psi, y - 1 )
+                      + 8.0f * PSI_Y( pml, psi, y + 1 ) - PSI_Y( pml, psi, y + 2 )) / 12.0f;
+        float d2 = -c[ y - 2 ] + 16.0f * c[ y - 1 ] - 30.0f * c[ y ] + 16.0f * c[ y + 1 ] - c[ y + 2 ];
+        zeta[ l ] = pml->by[ y ] * zeta[ l ] + pml->ay[ y ] * (d2 + dpsi);
+        n[ y ] += v[ y ] * (dpsi + zeta[ l ]);
+      }
+  }
+}
+
+void cpml_destroy( cpml_t * pml ) {
+  free( pml->ax );
+  free( pml->bx );
+  free( pml->ay );
+  free( pml->by );
+  free( pml->psi_x );
+  free( pml->zeta_x );
+  free( pml->psi_y );
+  free( pml->zeta_y );
+  free( pml->zero );
+  free( pml );
+}
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _CPML_H_
+#define _CPML_H_
+
+/*
+  Convolutional PML for the second order wave equation (Pasalic and
+  McGarry, 2010), per direction:
+    psi  = b * psi  + a * dP/dx
+    zeta = b * zeta + a * (d2P/dx2 + dpsi/dx)
+    P(n+1) += vel * (dpsi/dx + zeta)
+  The kernels update the whole grid as before, the correction above is
+  added afterwards, only within the 'thick' outer points of the propagated
+  area. psi and zeta are scaled by 12h and 12h^2, which makes them fit the
+  stencil of the kernels.
+  dpsi/dx needs psi of the neighbours of the same timestep, hence the left
+  and right layer must lie within the outer strips (x only splits strips).
+*/
+
+typedef struct _cpml_t cpml_t;
+struct _cpml_t {
+  unsigned width;
+  unsigned height;
+  unsigned thick;
+
+  float * ax; // per column, 0 outside the layer
+  float * bx;
+  float * ay; // per row
+  float * by;
+
+  float * psi_x; // [2 * thick][height], left then right layer
+  float * zeta_x;
+  float * psi_y; // [width][2 * thick], top then bottom layer
+  float * zeta_y;
+  float * zero; // [height], psi_x beyond the layers
+};
+
+cpml_t * cpml_create( unsigned width, unsigned height, unsigned thick, float v_max, double h, double dt, double fpeak );
+void cpml_apply( cpml_t * pml, unsigned x_start, unsigned x_end, const float * p, float * np, const float * vel );
+void cpml_destroy( cpml_t * pml );
+
+#endif /* #ifndef _CPML_H_ */
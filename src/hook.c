@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include "kernel.h"
+#include "snapshot.h"
+#include "movie.h"
+#include "checkpoint.h"
+#include "shmring.h"
+#include "receiver.h"
+#include "inject.h"
+#include "cpml.h"
+
+void seismic_hook( stack_t * data ) {
+
+  // damp the new frame within the absorbing layer, nppf still holds the one the kernel read
+  if( data->pml ) {
+    cpml_apply( data->pml, STRIP_X_START( data ), STRIP_X_END( data ), data->nppf, data->apf, data->vel );
+    TRACE_MARK( data->id, TRACE_PML, data->step - 1 );
+  }
+
+  // sources of the next timestep, like the pulse
+  if( data->inj ) {
+    INJECT_APPLY( data->inj, data->step, data->i_start, data->i_end, data->apf );
+    TRACE_MARK( data->id, TRACE_INJECT, data->step - 1 );
+  }
+
+  // sample the receivers of the own strip, in memory order
+  if( data->recv && ! (data->step % data->recv->subsample) ) {
+    RECEIVER_RECORD( data->recv, data->step / data->recv->subsample, data->r_start, data->r_end, data->apf );
+    TRACE_MARK( data->id, TRACE_RECEIVER, data->step - 1 );
+  }
+
+  // hand over the own strip of every 'keep'-th frame for compression
+  if( data->store && ! (data->step % data->keep) ) {
+    snapshot_store_put( data->store, data->step / data->keep - 1, data->id,
+                        STRIP_X_START( data ), STRIP_X_END( data ), data->apf );
+    TRACE_MARK( data->id, TRACE_SNAPSHOT, data->step - 1 );
+  }
+
+  // copy the own strip of every 'every'-th frame for the movie writer
+  if( data->movie && ! (data->step % data->every) ) {
+    movie_put( data->movie, data->step / data->every - 1, data->id,
+               STRIP_X_START( data ), STRIP_X_END( data ), data->apf );
+    TRACE_MARK( data->id, TRACE_MOVIE, data->step - 1 );
+  }
+
+  // copy the own strips of both frames for the checkpoint writer
+  if( data->ckpt && ! (data->step % data->ckpt_every) ) {
+    checkpoint_put( data->ckpt, data->step, data->id,
+                    STRIP_X_START( data ), STRIP_X_END( data ), data->apf, data->nppf );
+    TRACE_MARK( data->id, TRACE_CHECKPOINT, data->step - 1 );
+  }
+
+  // publish the own strip of every 'shm_every'-th frame, never waits
+  if( data->shm && ! (data->step % data->shm_every) ) {
+    shmring_put( data->shm, data->step / data->shm_every - 1,
+                 STRIP_X_START( data ), STRIP_X_END( data ), data->apf );
+    TRACE_MARK( data->id, TRACE_SHM, data->step - 1 );
+  }
+}
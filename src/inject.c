@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "inject.h"
+#include "receiver.h"
+
+#define TRACE_HEADER      240
+#define SEGY_FILE_HEADER  3600
+
+typedef struct _inject_src_t inject_src_t;
+struct _inject_src_t {
+  unsigned long offset;
+  unsigned trace;
+  float weight;
+};
+
+static int get16( const unsigned char * p, int be ) {
+  int16_t v;
+  if( be )
+    v = (int16_t)((p[0] << 8) | p[1]);
+  else
+    memcpy( &v, p, sizeof(v) );
+  return v;
+}
+
+static int32_t get32( const unsigned char * p, int be ) {
+  uint32_t u;
+  if( be )
+    u = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  else
+    memcpy( &u, p, sizeof(u) );
+  return (int32_t)u;
+}
+
+// SEG-Y coordinate scalars: negative divides, positive multiplies
+static double scaled( int32_t v, int scalar ) {
+  if( scalar < 0 )
+    return (double)v / -scalar;
+  if( scalar > 0 )
+    return (double)v * scalar;
+  return (double)v;
+}
+
+static int inject_cmp( const void * a, const void * b ) {
+  const inject_src_t * pa = (const inject_src_t*) a;
+  const inject_src_t * pb = (const inject_src_t*) b;
+  if( pa->offset != pb->offset )
+    return pa->offset < pb->offset ? -1 : 1;
+  return pa->trace < pb->trace ? -1 : pa->trace > pb->trace;
+}
+
+/*
+  unique points of the n contributions in memory order, amplitudes are
+  left zero. point[ c ] is the point of contribution c.
+*/
+static inject_t * inject_points( inject_src_t * src, unsigned n, unsigned height, unsigned timesteps, unsigned * point ) {
+  inject_t * inj = (inject_t*) calloc( 1, sizeof(inject_t) );
+  if( inj == NULL )
+    return NULL;
+
+  qsort( src, n, sizeof(inject_src_t), inject_cmp );
+  inj->offset = (unsigned long*) malloc( n * sizeof(unsigned long) );
+  inj->x = (unsigned*) malloc( n * sizeof(unsigned) );
+  if( inj->offset == NULL || inj->x == NULL ) {
+    inject_destroy( inj );
+    return NULL;
+  }
+
+  unsigned c;
+  for( c = 0; c < n; c++ ) {
+    if( ! inj->count || inj->offset[ inj->count - 1 ] != src[ c ].offset ) {
+      inj->offset[ inj->count ] = src[ c ].offset;
+      inj->x[ inj->count ] = src[ c ].offset / height;
+      inj->count++;
+    }
+    point[ c ] = inj->count - 1;
+  }
+
+  inj->steps = timesteps + 1;
+  inj->amp = (float*) calloc( (unsigned long)inj->steps * inj->count, sizeof(float) );
+  if( inj->amp == NULL ) {
+    inject_destroy( inj );
+    return NULL;
+  }
+
+  return inj;
+}
+
+inject_t * inject_create( const char * file, unsigned width, unsigned height, unsigned border, unsigned origin, unsigned timesteps, double h, double dt ) {
+  int be = receiver_is_segy( file );
+
+  FILE * f = fopen( file, "rb" );
+  if( f == NULL ) {
+    fprintf(stderr, "ERROR: could not open '%s'\n", file);
+    exit(EXIT_FAILURE);
+  }
+  if( be && fseek( f, SEGY_FILE_HEADER, SEEK_SET ) ) {
+    fprintf(stderr, "ERROR: '%s' has no SEG-Y file header\n", file);
+    exit(EXIT_FAILURE);
+  }
+
+  // all traces (fixed length), and four weighted grid points per trace
+  unsigned traces = 0, cap = 0, ns = 0, n = 0;
+  double dt_tr = 0.0;
+  float * data = NULL;
+  inject_src_t * src = NULL;
+  unsigned char hdr[ TRACE_HEADER ];
+  while( fread( hdr, 1, sizeof(hdr), f ) == sizeof(hdr) ) {
+    if( ! traces ) {
+      ns = (uint16_t)get16( &hdr[ 114 ], be );
+      dt_tr = (uint16_t)get16( &hdr[ 116 ], be ) * 1e-6;
+      if( ns < 2 || dt_tr <= 0.0 ) {
+        fprintf(stderr, "ERROR: '%s' has no samples or no sample interval\n", file);
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if( (uint16_t)get16( &hdr[ 114 ], be ) != ns ) {
+      fprintf(stderr, "ERROR: '%s': trace %u differs in length\n", file, traces + 1);
+      exit(EXIT_FAILURE);
+    }
+
+    if( traces == cap ) {
+      cap = cap ? cap * 2 : 256;
+      data = (float*) realloc( data, (unsigned long)cap * ns * sizeof(float) );
+      src = (inject_src_t*) realloc( src, 4 * (unsigned long)cap * sizeof(inject_src_t) );
+      if( data == NULL || src == NULL ) {
+        fprintf(stderr, "ERROR: inject allocation failure\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    float * t = &data[ (unsigned long)traces * ns ];
+    if( fread( t, sizeof(float), ns, f ) != ns ) {
+      fprintf(stderr, "ERROR: '%s': trace %u is truncated\n", file, traces + 1);
+      exit(EXIT_FAILURE);
+    }
+    if( be ) {
+      unsigned s;
+      for( s = 0; s < ns; s++ ) {
+        int32_t v = get32( (const unsigned char*) &t[ s ], be );
+        memcpy( &t[ s ], &v, sizeof(v) );
+      }
+    }
+
+    // receiver position in grid points, depth is the negative elevation
+    double fx = scaled( get32( &hdr[ 80 ], be ), get16( &hdr[ 70 ], be ) ) / h + border - (double)origin;
+    double fy = -scaled( get32( &hdr[ 40 ], be ), get16( &hdr[ 68 ], be ) ) / h + border;
+    if( fx < 2.0 || fy < 2.0 || fx > width - 3 || fy > height - 3 ) {
+      fprintf(stderr, "ERROR: '%s': trace %u is outside of the propagated area\n", file, traces + 1);
+      exit(EXIT_FAILURE);
+    }
+
+    // bilinear weights of the surrounding grid points
+    unsigned x0 = (unsigned)fx, y0 = (unsigned)fy, i;
+    double wx = fx - x0, wy = fy - y0;
+    for( i = 0; i < 4; i++ ) {
+      double w = ((i & 0x1) ? wx : 1.0 - wx) * ((i & 0x2) ? wy : 1.0 - wy);
+      if( w == 0.0 )
+        continue;
+      src[ n ].offset = (unsigned long)(x0 + (i & 0x1)) * height + y0 + ((i >> 1) & 0x1);
+      src[ n ].trace = traces;
+      src[ n ].weight = (float)w;
+      n++;
+    }
+    traces++;
+  }
+  fclose( f );
+
+  if( ! traces ) {
+    fprintf(stderr, "ERROR: no traces in '%s'\n", file);
+    exit(EXIT_FAILURE);
+  }
+
+  unsigned * point = (unsigned*) malloc( n * sizeof(unsigned) );
+  inject_t * inj = point ? inject_points( src, n, height, timesteps, point ) : NULL;
+  if( inj == NULL ) {
+    free( point );
+    return NULL;
+  }
+
+  // step k of the run sees the traces at time t_end - k * dt (linear)
+  double t_end = (ns - 1) * dt_tr;
+  unsigned k, c;
+  for( k = 0; k < inj->steps; k++ ) {
+    double pos = (t_end - k * dt) / dt_tr;
+    if( pos < 0.0 )
+      break;
+    unsigned s = (unsigned)pos;
+    float frac = (float)(pos - s);
+    if( s + 1 >= ns ) {
+      s = ns - 2;
+      frac = 1.0f;
+    }
+
+    float * row = &inj->amp[ (unsigned long)k * inj->count ];
+    for( c = 0; c < n; c++ ) {
+      const float * t = &data[ (unsigned long)src[ c ].trace * ns ];
+      row[ point[ c ] ] += src[ c ].weight * ((1.0f - frac) * t[ s ] + frac * t[ s + 1 ]);
+    }
+  }
+
+  free( point );
+  free( src );
+  free( data );
+  return inj;
+}
+
+static void inject_add_source( inject_src_t ** src, unsigned ** delays, unsigned * n, unsigned * cap,
+                               unsigned long offset, unsigned delay, float pol ) {
+  if( *n == *cap ) {
+    *cap = *cap ? *cap * 2 : 64;
+    *src = (inject_src_t*) realloc( *src, *cap * sizeof(inject_src_t) );
+    *delays = (unsigned*) realloc( *delays, *cap * sizeof(unsigned) );
+    if( *src == NULL || *delays == NULL ) {
+      fprintf(stderr, "ERROR: inject allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  (*src)[ *n ].offset = offset;
+  (*src)[ *n ].trace = *n;
+  (*src)[ *n ].weight = pol;
+  (*delays)[ *n ] = delay;
+  (*n)++;
+}
+
+/*
+  Sources on grid points, all firing the pulse, each with its own delay (in
+  timesteps) and polarity. A seed != 0 flips polarities at random, which
+  encodes the shots for blended imaging.
+  spec: "x0:x1:dx@y" for a line of sources, otherwise the name of a file
+  with "x y [delay [polarity]]" per line ('#' starts a comment).
+*/
+inject_t * inject_sources( const char * spec, unsigned width, unsigned height, unsigned border, unsigned origin, unsigned timesteps, const float * pulsevector, unsigned seed ) {
+  unsigned n = 0, cap = 0, x0, x1, dx, y, delay;
+  inject_src_t * src = NULL;
+  unsigned * delays = NULL;
+  float pol;
+  char c;
+
+  // collect in model coordinates, offset is x * height + y for now
+  if( sscanf( spec, "%u:%u:%u@%u%c", &x0, &x1, &dx, &y, &c ) == 4 ) {
+    if( ! dx || x1 < x0 ) {
+      fprintf(stderr, "ERROR: sources '%s' need x0 <= x1 and dx > 0\n", spec);
+      exit(EXIT_FAILURE);
+    }
+    for( ; x0 <= x1; x0 += dx )
+      inject_add_source( &src, &delays, &n, &cap, (unsigned long)x0 * height + (y < height ? y : height - 1), 0, 1.0f );
+  }
+  else {
+    FILE * f = fopen( spec, "r" );
+    if( f == NULL ) {
+      fprintf(stderr, "ERROR: sources '%s' are neither x0:x1:dx@y nor a readable file\n", spec);
+      exit(EXIT_FAILURE);
+    }
+    char line[256];
+    unsigned l = 0;
+    while( fgets( line, sizeof(line), f ) ) {
+      l++;
+      char * p = strchr( line, '#' );
+      if( p )
+        *p = '\0';
+      delay = 0;
+      pol = 1.0f;
+      int r = sscanf( line, "%u %u %u %f %c", &x0, &y, &delay, &pol, &c );
+      if( r == EOF )
+        continue;
+      if( r < 2 || r > 4 ) {
+        fprintf(stderr, "ERROR: %s:%u: expected 'x y [delay [polarity]]'\n", spec, l);
+        exit(EXIT_FAILURE);
+      }
+      inject_add_source( &src, &delays, &n, &cap, (unsigned long)x0 * height + (y < height ? y : height - 1), delay, pol );
+    }
+    fclose( f );
+  }
+
+  if( ! n ) {
+    fprintf(stderr, "ERROR: no sources in '%s'\n", spec);
+    exit(EXIT_FAILURE);
+  }
+
+  unsigned i;
+  for( i = 0; i < n; i++ ) {
+    if( src[ i ].offset % height + 2 * border >= height ) {
+      fprintf(stderr, "ERROR: source %u is below the model\n", i);
+      exit(EXIT_FAILURE);
+    }
+    // wraps for sources left of the grid, which then fail below
+    unsigned x = src[ i ].offset / height + border - origin;
+    y = src[ i ].offset % height + border;
+    if( x < 2 || y < 2 || x >= width - 2 || y >= height - 2 ) {
+      fprintf(stderr, "ERROR: source %u (%u, %u) is outside of the propagated area\n", i, x - border + origin, y - border);
+      exit(EXIT_FAILURE);
+    }
+    src[ i ].offset = (unsigned long)x * height + y;
+    if( seed && (rand_r( &seed ) & 0x1) )
+      src[ i ].weight = -src[ i ].weight;
+  }
+
+  unsigned * point = (unsigned*) malloc( n * sizeof(unsigned) );
+  inject_t * inj = point ? inject_points( src, n, height, timesteps, point ) : NULL;
+  if( inj == NULL ) {
+    free( point );
+    return NULL;
+  }
+
+  // step k fires pulse k - delay, as the pulse itself does
+  unsigned k;
+  for( k = 0; k < inj->steps; k++ ) {
+    float * row = &inj->amp[ (unsigned long)k * inj->count ];
+    for( i = 0; i < n; i++ )
+      if( k >= delays[ src[ i ].trace ] )
+        row[ point[ i ] ] += src[ i ].weight * pulsevector[ k - delays[ src[ i ].trace ] ];
+  }
+
+  free( point );
+  free( delays );
+  free( src );
+  return inj;
+}
+
+// points with x_start <= x < x_end
+void inject_range( inject_t * inj, unsigned x_start, unsigned x_end, unsigned * i_start, unsigned * i_end ) {
+  unsigned i = 0;
+  while( i < inj->count && inj->x[ i ] < x_start )
+    i++;
+  *i_start = i;
+  while( i < inj->count && inj->x[ i ] < x_end )
+    i++;
+  *i_end = i;
+}
+
+void inject_destroy( inject_t * inj ) {
+  free( inj->offset );
+  free( inj->x );
+  free( inj->amp );
+  free( inj );
+}
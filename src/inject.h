@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _INJECT_H_
+#define _INJECT_H_
+
+/*
+  Injection of many traces at once, e.g. the receiver traces of a shot
+  gather for the backward propagation of RTM, or many (encoded) sources
+  firing the pulse within one propagation.
+
+  Every trace is spread onto the grid points around its (off-grid) position
+  with bilinear weights, and resampled from its own time axis, reversed, to
+  the timesteps of the run. Points hit by several traces are merged, so the
+  result is a list of unique grid points ordered by their offset into the
+  matrices, with the summed amplitudes stored per timestep [step][point].
+  Every thread then owns a contiguous range of points (inside its x-strip)
+  and adds one contiguous row of amplitudes per timestep.
+*/
+
+typedef struct _inject_t inject_t;
+struct _inject_t {
+  unsigned count; // grid points
+  unsigned long * offset; // ascending, unique
+  unsigned * x; // per point, incl. random boundary
+
+  unsigned steps; // amplitude rows, timesteps + 1
+  float * amp; // [step][point]
+};
+
+inject_t * inject_create( const char * file, unsigned width, unsigned height, unsigned border, unsigned origin, unsigned timesteps, double h, double dt );
+inject_t * inject_sources( const char * spec, unsigned width, unsigned height, unsigned border, unsigned origin, unsigned timesteps, const float * pulsevector, unsigned seed );
+void inject_range( inject_t * inj, unsigned x_start, unsigned x_end, unsigned * i_start, unsigned * i_end );
+void inject_destroy( inject_t * inj );
+
+// adds the amplitudes of 'step' to the points [i_start, i_end)
+#define INJECT_APPLY( inj, step, i_start, i_end, apf ) \
+  { \
+    const unsigned long * _off = (inj)->offset; \
+    const float * _amp = &(inj)->amp[ (unsigned long)(step) * (inj)->count ]; \
+    unsigned _i; \
+    /* offsets are unique, no two iterations touch the same point */ \
+    _Pragma("GCC ivdep") \
+    for( _i = (i_start); _i < (i_end); _i++ ) \
+      (apf)[ _off[ _i ] ] += _amp[ _i ]; \
+  }
+
+#endif /* #ifndef _INJECT_H_ */
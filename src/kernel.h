@@ -9,6 +9,9 @@
 #include <sys/time.h>
 #include "barrier/barrier.h"
 #include "check_hw.h"
+#include "perf.h"
+#include "prof.h"
+#include "trace.h"
 
 typedef struct _stack_t stack_t;
 struct _stack_t {
@@ -23,6 +26,8 @@ struct _stack_t {
   unsigned width;
   unsigned x_start;
   unsigned x_end;
+  unsigned strip_x_start; // own strip, x_start / x_end may be narrowed to the active columns
+  unsigned strip_x_end;
 
   unsigned height;
   unsigned y_start;
@@ -30,24 +35,163 @@ struct _stack_t {
   unsigned y_offset;
   unsigned timesteps;
 
+  unsigned depth; // 3D only, 1 otherwise: [x][z][y]
+  unsigned z_start;
+  unsigned z_end;
+  unsigned z_block; // rows of z streamed along x at once
+
   unsigned x_pulse;
   unsigned y_pulse;
+  unsigned z_pulse;
 
   unsigned set_pulse;
   unsigned clopt;
 
+  unsigned step; // timesteps done, counted by SEISMIC_STEP()
+  unsigned hooks; // anything to do per timestep beside the kernel?
+
+  struct _snapshot_store_t * store; // keeps every 'keep'-th frame
+  unsigned keep;
+
+  struct _movie_t * movie; // writes every 'every'-th frame
+  unsigned every;
+
+  struct _checkpoint_t * ckpt; // saves every 'ckpt_every'-th timestep
+  unsigned ckpt_every;
+
+  struct _shmring_t * shm; // publishes every 'shm_every'-th frame
+  unsigned shm_every;
+
+  struct _receiver_t * recv; // records traces of [r_start, r_end)
+  unsigned r_start;
+  unsigned r_end;
+
+  struct _inject_t * inj; // adds traces at [i_start, i_end)
+  unsigned i_start;
+  unsigned i_end;
+
+  struct _cpml_t * pml; // absorbing layer, NULL: none
+  struct _velocity_t * model; // converted into vel at start-up
+  struct _perf_t * perf; // hardware counters, NULL: none
+  struct _prof_t * prof; // compute / wait per timestep, NULL: none
+
+  unsigned reach; // columns the wavefield may spread per timestep, 0: whole strip
+  unsigned act_start; // columns [act_start, act_end) might be non-zero
+  unsigned act_end;
+
   struct timeval s;
   struct timeval e;
 };
 
+void seismic_hook( stack_t * data );
+
+// the outer strips also carry the (never updated) boundary columns
+#define STRIP_X_START( data )   ((data)->strip_x_start == 2 ? 0 : (data)->strip_x_start)
+#define STRIP_X_END( data )     ((data)->strip_x_end == (data)->width - 2 ? (data)->width : (data)->strip_x_end)
+
+/*
+  grows the active columns by the reach of one timestep and narrows the
+  columns the kernel updates next to those within the own strip. Everything
+  outside is still zero and would stay zero. Once the active columns cover
+  the whole matrix the kernel gets its full strip back for good.
+  The strips stay where they are, a thread the wavefield has not reached
+  idles at the barrier: the pulse and the hooks of SEISMIC_STEP() run on
+  the own strip before the barrier, so only its owner may update it.
+  Handing columns to other threads would need a second barrier per
+  timestep in every kernel.
+*/
+#define SEISMIC_TRACK( data ) \
+  { \
+    (data)->act_start = (data)->act_start > 2 + (data)->reach ? (data)->act_start - (data)->reach : 2; \
+    (data)->act_end = (data)->act_end + (data)->reach < (data)->width - 2 ? (data)->act_end + (data)->reach : (data)->width - 2; \
+    (data)->x_start = (data)->act_start > (data)->strip_x_start ? (data)->act_start : (data)->strip_x_start; \
+    (data)->x_end = (data)->act_end < (data)->strip_x_end ? (data)->act_end : (data)->strip_x_end; \
+    if( (data)->x_end < (data)->x_start ) \
+      (data)->x_end = (data)->x_start; \
+    if( (data)->act_start == 2 && (data)->act_end == (data)->width - 2 ) \
+      (data)->reach = 0; \
+  }
+
+/*
+  executed by each thread after every timestep, once the pointers are
+  switched and the pulse is inserted. Only the own strip of data->apf is
+  guaranteed to be complete here.
+*/
+#define SEISMIC_STEP( data ) \
+  { \
+    TRACE_MARK( (data)->id, TRACE_KERNEL, (data)->step ); \
+    (data)->step++; \
+    if( (data)->reach ) \
+      SEISMIC_TRACK( (data) ); \
+    if( (data)->hooks ) \
+      seismic_hook( (data) ); \
+    if( (data)->prof ) \
+      PROF_STEP( (data)->prof, (data)->id ); \
+  }
+
+// the barriers within the time loop, see prof.h
+#define SEISMIC_BARRIER( data ) \
+  { \
+    if( (data)->prof ) \
+      PROF_ENTER( (data)->prof, (data)->id ); \
+    TRACE_MARK( (data)->id, TRACE_KERNEL, (data)->step ); \
+    BARRIER( (data)->barrier, (data)->id ); \
+    TRACE_MARK( (data)->id, TRACE_BARRIER, (data)->step ); \
+    if( (data)->prof ) \
+      PROF_LEAVE( (data)->prof, (data)->id ); \
+  }
+
+/*
+  bracket the time loop: the timestamps of INNER, the counters of --perf,
+  which stay outside of the timestamps, the records of --imbalance and
+  the slices of --timeline.
+*/
+#define SEISMIC_LOOP_BEGIN( data ) \
+  { \
+    if( (data)->perf ) \
+      perf_begin( (data) ); \
+    gettimeofday( &(data)->s, NULL ); \
+    if( (data)->prof ) \
+      PROF_BEGIN( (data)->prof, (data)->id ); \
+    TRACE_START( (data)->id ); \
+  }
+
+#define SEISMIC_LOOP_END( data ) \
+  { \
+    TRACE_MARK( (data)->id, TRACE_KERNEL, (data)->step ); \
+    if( (data)->prof ) \
+      prof_end( (data)->prof, (data)->id ); \
+    gettimeofday( &(data)->e, NULL ); \
+    if( (data)->perf ) \
+      perf_end( (data) ); \
+  }
+
+/*
+  the roofline of the kernels: floating-point operations and the least
+  memory traffic (apf, nppf and vel read, nppf written) per grid point
+  and timestep.
+*/
+#define KERNEL_FLOPS( DIMS )    ((DIMS) == 3 ? 19 : 15)
+#define KERNEL_BYTES            (4 * sizeof(float))
+
 #define SYM_KERNEL( NAME, CAP, ALIGNMENT, VECTORWIDTH ) \
+  SYM_KERNEL_DIMS( NAME, ALIGNMENT, VECTORWIDTH, 2, CAP )
+
+#define SYM_KERNEL_3D( NAME, CAP, ALIGNMENT, VECTORWIDTH ) \
+  SYM_KERNEL_DIMS( NAME, ALIGNMENT, VECTORWIDTH, 3, CAP )
+
+// CAP comes last, its expansion may contain commas
+#define SYM_KERNEL_DIMS( NAME, ALIGNMENT, VECTORWIDTH, DIMS, ... ) \
 sym_kernel_t sym_##NAME = { \
   .name = #NAME, \
-  .cap.in = CAP, \
+  .cap.in = __VA_ARGS__, \
   .fnc_sgl = seismic_exec_##NAME, \
   .fnc_par = seismic_exec_##NAME##_pthread, \
   .alignment = ALIGNMENT, \
-  .vectorwidth = VECTORWIDTH \
+  .vectorwidth = VECTORWIDTH, \
+  .dims = DIMS, \
+  .flops = KERNEL_FLOPS( DIMS ), \
+  .bytes = KERNEL_BYTES \
 }; \
 extern unsigned sym_kern_c; \
 extern sym_kernel_t* sym_kern[]; \
@@ -63,6 +207,9 @@ struct _sym_kernel_t {
   void (*fnc_par)( void * v );
   unsigned int alignment;
   unsigned int vectorwidth;
+  unsigned int dims; // 2: [x][y], 3: [x][z][y]
+  unsigned int flops; // per grid point and timestep
+  unsigned int bytes;
 };
 
 #endif /* #ifndef _KERNEL_H_ */
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _KERNEL_3D_H_
+#define _KERNEL_3D_H_
+#include <stddef.h>
+#include "kernel.h"
+
+/*
+  3D: 13 point stencil, 4th order in x, z and y. The matrices are stored as
+  [x][z][y], y is contiguous (and vectorised), x the slowest axis.
+  Every thread owns a block of rows (y) and columns (z) over all of x.
+
+  2.5D blocking: z_block columns of the own block are streamed along x at
+  once, hence the five planes x-2 .. x+2 of them stay in cache and every
+  value of APF is loaded from memory once per timestep.
+*/
+
+// bytes of cache a thread may fill with the five planes of its z-block
+#define KERNEL_3D_CACHE     (256 * 1024)
+
+#define SEISMIC_OFFSET_3D( data, x, z, y ) \
+  ((((size_t)(x) * (data)->depth) + (z)) * (data)->height + (y))
+
+// z-block, then x, then the columns of the z-block
+#define KERNEL_3D_FOREACH_COLUMN( data, x, z ) \
+  unsigned _zb; \
+  for( _zb = (data)->z_start; _zb < (data)->z_end; _zb += (data)->z_block ) \
+    for( (x) = (data)->x_start; (x) < (data)->x_end; (x)++ ) \
+      for( (z) = _zb; (z) < _zb + (data)->z_block && (z) < (data)->z_end; (z)++ )
+
+// function that implements the kernel of the seismic modeling algorithm
+#define SEISMIC_EXEC_3D_FCT( NAME ) \
+void seismic_exec_##NAME( void * v ) \
+{ \
+    stack_t * data = (stack_t*) v; \
+    size_t pulse = SEISMIC_OFFSET_3D( data, data->x_pulse, data->z_pulse, data->y_pulse ); \
+ \
+    /* inserts the seismic pulse value in the desired position */ \
+    data->apf[ pulse ] += data->pulsevector[0]; \
+ \
+    SEISMIC_LOOP_BEGIN( data ); \
+ \
+    /* time loop */ \
+    unsigned t, p; \
+    for (t = 0, p = 0; t < data->timesteps; t++) \
+    { \
+        kernel_##NAME( data ); \
+ \
+        /* switch pointers instead of copying data */ \
+        float * tmp = data->nppf; \
+        data->nppf = data->apf; \
+        data->apf = tmp; \
+ \
+        /* + 1 because we add the pulse for the _next_ time step */ \
+        data->apf[ pulse ] += data->pulsevector[t+1]; \
+        SEISMIC_STEP( data ); \
+ \
+        /* shows one # at each 10% of the total processing time */ \
+        if( t == p ) \
+        { \
+            p += data->timesteps / 10; \
+            printf("#"); \
+            fflush(stdout); \
+        } \
+    } \
+ \
+    SEISMIC_LOOP_END( data ); \
+} \
+ \
+ \
+void seismic_exec_##NAME##_pthread( void * v ) \
+{ \
+    stack_t * data = (stack_t*) v; \
+    size_t pulse = SEISMIC_OFFSET_3D( data, data->x_pulse, data->z_pulse, data->y_pulse ); \
+ \
+    if( data->set_pulse ) \
+        data->apf[ pulse ] += data->pulsevector[0]; \
+ \
+    /* start everything in parallel */ \
+    BARRIER( data->barrier, data->id ); \
+ \
+    SEISMIC_LOOP_BEGIN( data ); \
+ \
+    /* time loop */ \
+    unsigned t, p; \
+    for (t = 0, p = 0; t < data->timesteps; t++) \
+    { \
+        kernel_##NAME( data ); \
+ \
+        /* switch pointers instead of copying data */ \
+        float * tmp = data->nppf; \
+        data->nppf = data->apf; \
+        data->apf = tmp; \
+ \
+        /* + 1 because we add the pulse for the _next_ time step */ \
+        if( data->set_pulse ) \
+            data->apf[ pulse ] += data->pulsevector[t+1]; \
+        SEISMIC_STEP( data ); \
+ \
+        /* shows one # at each 10% of the total processing time */ \
+        if( ! data->id && t == p ) \
+        { \
+            p += data->timesteps / 10; \
+            printf("#"); \
+            fflush(stdout); \
+        } \
+ \
+        SEISMIC_BARRIER( data ); \
+    } \
+ \
+    SEISMIC_LOOP_END( data ); \
+ \
+    if( data->id ) \
+        pthread_exit( NULL ); \
+}
+
+#endif /* #ifndef _KERNEL_3D_H_ */
@@ -11,17 +11,17 @@ inline __attribute__((always_inline)) void kernel_arm_neon_aligned( stack_t * da
     unsigned i, j;
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
         float32x4_t neon_left_pre  = vld1q_f32( (const float32_t *) &data->apf[ r - 4 ] );
         float32x4_t neon_actual = vld1q_f32( (const float32_t *) &data->apf[ r ] );
         float32x4_t neon_left2 = vextq_f32( neon_left_pre, neon_actual, 2 );
         
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4, r+=4) {
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
 
             float32x4_t neon_ppf = vld1q_f32( (const float32_t *) &data->nppf[ r ] );
             float32x4_t neon_vel = vld1q_f32( (const float32_t *) &data->vel[ r ] );
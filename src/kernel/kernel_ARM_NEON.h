@@ -21,12 +21,12 @@ void seismic_exec_arm_neon_##NAME( void * v ) \
     float32x4_t neon_sixteen = vld1q_dup_f32( (const float32_t *) &sixteen ); \
     float32x4_t neon_minus_sixty = vld1q_dup_f32( (const float32_t *) &min_sixty ); \
  \
-    data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+    data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t, r, t_tmp = 0; \
@@ -42,7 +42,8 @@ void seismic_exec_arm_neon_##NAME( void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            SEISMIC_STEP( data ); \
         } \
  \
         /* shows one # at each 10% of the total processing time */ \
@@ -62,10 +63,11 @@ void seismic_exec_arm_neon_##NAME( void * v ) \
  \
         /* + 1 because we add the pulse for the _next_ time step */ \
         /* inserts the seismic pulse value in the desired position */ \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        SEISMIC_STEP( data ); \
     } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
 } \
  \
  \
@@ -83,7 +85,7 @@ void seismic_exec_arm_neon_##NAME##_pthread( void * v ) \
     float32x4_t neon_minus_sixty = vld1q_dup_f32( (const float32_t *) &min_sixty ); \
  \
     if( data->set_pulse ) \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
@@ -91,7 +93,7 @@ void seismic_exec_arm_neon_##NAME##_pthread( void * v ) \
     /* start everything in parallel */ \
     BARRIER( data->barrier, data->id ); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t; \
@@ -110,9 +112,10 @@ void seismic_exec_arm_neon_##NAME##_pthread( void * v ) \
  \
                 /* + 1 because we add the pulse for the _next_ time step */ \
                 /* inserts the seismic pulse value in the desired position */ \
-                data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                SEISMIC_STEP( data ); \
  \
-                BARRIER( data->barrier, data->id ); \
+                SEISMIC_BARRIER( data ); \
             } \
  \
             /* shows one # at each 10% of the total processing time */ \
@@ -132,9 +135,10 @@ void seismic_exec_arm_neon_##NAME##_pthread( void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
     } \
     else \
@@ -146,11 +150,12 @@ void seismic_exec_arm_neon_##NAME##_pthread( void * v ) \
             float * tmp = data->nppf; \
             data->nppf = data->apf; \
             data->apf = tmp; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
  \
     if( data->id ) \
         pthread_exit( NULL ); \
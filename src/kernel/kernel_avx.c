@@ -13,11 +13,11 @@ inline __attribute__((always_inline)) void kernel_avx_unaligned( stack_t * data,
     for (i=data->x_start; i<data->x_end; i++) {
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=8) {
-            unsigned r = i * data->height + j;
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height * 2);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height * 2);
+            size_t r = (size_t)i * data->height + j;
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height * 2);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height * 2);
 
             // calculates the pressure field t+1
             s_ppf_aligned = _mm256_loadu_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -22,12 +22,12 @@ void seismic_exec_avx_##NAME( void * v ) \
     __m256 s_sixteen = _mm256_broadcast_ss( (const float*) &sixteen ); \
     __m256 s_min_sixty = _mm256_broadcast_ss( (const float*) &min_sixty ); \
  \
-    data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+    data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t, r, t_tmp = 0; \
@@ -43,7 +43,8 @@ void seismic_exec_avx_##NAME( void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            SEISMIC_STEP( data ); \
         } \
  \
         /* shows one # at each 10% of the total processing time */ \
@@ -63,10 +64,11 @@ void seismic_exec_avx_##NAME( void * v ) \
  \
         /* + 1 because we add the pulse for the _next_ time step */ \
         /* inserts the seismic pulse value in the desired position */ \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        SEISMIC_STEP( data ); \
     } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
 } \
  \
  \
@@ -84,7 +86,7 @@ void seismic_exec_avx_##NAME##_pthread(void * v ) \
     __m256 s_min_sixty = _mm256_broadcast_ss( (const float*) &min_sixty ); \
  \
     if( data->set_pulse ) \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
@@ -92,7 +94,7 @@ void seismic_exec_avx_##NAME##_pthread(void * v ) \
     /* start everything in parallel */ \
     BARRIER( data->barrier, data->id ); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t; \
@@ -111,9 +113,10 @@ void seismic_exec_avx_##NAME##_pthread(void * v ) \
  \
                 /* + 1 because we add the pulse for the _next_ time step */ \
                 /* inserts the seismic pulse value in the desired position */ \
-                data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                SEISMIC_STEP( data ); \
  \
-                BARRIER( data->barrier, data->id ); \
+                SEISMIC_BARRIER( data ); \
             } \
  \
             /* shows one # at each 10% of the total processing time */ \
@@ -133,9 +136,10 @@ void seismic_exec_avx_##NAME##_pthread(void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
     } \
     else \
@@ -147,11 +151,12 @@ void seismic_exec_avx_##NAME##_pthread(void * v ) \
             float * tmp = data->nppf; \
             data->nppf = data->apf; \
             data->apf = tmp; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
  \
     if( data->id ) \
         pthread_exit( NULL ); \
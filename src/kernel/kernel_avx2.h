@@ -50,12 +50,12 @@ void seismic_exec_avx2_##NAME( void * v ) \
     __m256i s_shl, s_shr; \
     init_shuffle( &s_shl, &s_shr ); \
  \
-    data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+    data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t, r, t_tmp = 0; \
@@ -71,7 +71,8 @@ void seismic_exec_avx2_##NAME( void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            SEISMIC_STEP( data ); \
         } \
  \
         /* shows one # at each 10% of the total processing time */ \
@@ -91,10 +92,11 @@ void seismic_exec_avx2_##NAME( void * v ) \
  \
         /* + 1 because we add the pulse for the _next_ time step */ \
         /* inserts the seismic pulse value in the desired position */ \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        SEISMIC_STEP( data ); \
     } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
 } \
  \
  \
@@ -115,7 +117,7 @@ void seismic_exec_avx2_##NAME##_pthread(void * v ) \
     init_shuffle( &s_shl, &s_shr ); \
  \
     if( data->set_pulse ) \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
@@ -123,7 +125,7 @@ void seismic_exec_avx2_##NAME##_pthread(void * v ) \
     /* start everything in parallel */ \
     BARRIER( data->barrier, data->id ); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t; \
@@ -142,9 +144,10 @@ void seismic_exec_avx2_##NAME##_pthread(void * v ) \
  \
                 /* + 1 because we add the pulse for the _next_ time step */ \
                 /* inserts the seismic pulse value in the desired position */ \
-                data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                SEISMIC_STEP( data ); \
  \
-                BARRIER( data->barrier, data->id ); \
+                SEISMIC_BARRIER( data ); \
             } \
  \
             /* shows one # at each 10% of the total processing time */ \
@@ -164,9 +167,10 @@ void seismic_exec_avx2_##NAME##_pthread(void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
     } \
     else \
@@ -178,11 +182,12 @@ void seismic_exec_avx2_##NAME##_pthread(void * v ) \
             float * tmp = data->nppf; \
             data->nppf = data->apf; \
             data->apf = tmp; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
  \
     if( data->id ) \
         pthread_exit( NULL ); \
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include "kernel_3d.h"
+#include <immintrin.h>
+
+inline __attribute__((always_inline)) void kernel_avx2_fma_3d( stack_t * data )
+{
+    const ptrdiff_t col = data->height;
+    const ptrdiff_t plane = (ptrdiff_t)data->depth * data->height;
+    unsigned x, y, z;
+
+    __m256 s_two = _mm256_set1_ps( 2.0f );
+    __m256 s_sixteen = _mm256_set1_ps( 16.0f );
+    __m256 s_min_ninety = _mm256_set1_ps( -90.0f );
+
+    KERNEL_3D_FOREACH_COLUMN( data, x, z ) {
+        size_t r = SEISMIC_OFFSET_3D( data, x, z, 0 );
+        const float * apf = &data->apf[ r ];
+        const float * vel = &data->vel[ r ];
+        float * nppf = &data->nppf[ r ];
+
+        // spatial loop in y
+        for (y=data->y_start; y<data->y_end; y+=8) {
+            __m256 s_actual = _mm256_loadu_ps( &apf[ y ] );
+
+            __m256 s_in = _mm256_add_ps( _mm256_loadu_ps( &apf[ y - 1 ] ), _mm256_loadu_ps( &apf[ y + 1 ] ) );
+            s_in = _mm256_add_ps( s_in, _mm256_loadu_ps( &apf[ y - col ] ) );
+            s_in = _mm256_add_ps( s_in, _mm256_loadu_ps( &apf[ y + col ] ) );
+            s_in = _mm256_add_ps( s_in, _mm256_loadu_ps( &apf[ y - plane ] ) );
+            s_in = _mm256_add_ps( s_in, _mm256_loadu_ps( &apf[ y + plane ] ) );
+
+            __m256 s_out = _mm256_add_ps( _mm256_loadu_ps( &apf[ y - 2 ] ), _mm256_loadu_ps( &apf[ y + 2 ] ) );
+            s_out = _mm256_add_ps( s_out, _mm256_loadu_ps( &apf[ y - 2 * col ] ) );
+            s_out = _mm256_add_ps( s_out, _mm256_loadu_ps( &apf[ y + 2 * col ] ) );
+            s_out = _mm256_add_ps( s_out, _mm256_loadu_ps( &apf[ y - 2 * plane ] ) );
+            s_out = _mm256_add_ps( s_out, _mm256_loadu_ps( &apf[ y + 2 * plane ] ) );
+
+            // 16 * in - 90 * actual - out, then 2 * actual - nppf + vel * lap
+            __m256 s_lap = _mm256_sub_ps( _mm256_fmadd_ps( s_sixteen, s_in,
+                                                           _mm256_mul_ps( s_min_ninety, s_actual ) ),
+                                          s_out );
+            __m256 s_sum = _mm256_fmadd_ps( _mm256_loadu_ps( &vel[ y ] ), s_lap,
+                                            _mm256_fmsub_ps( s_two, s_actual, _mm256_loadu_ps( &nppf[ y ] ) ) );
+
+            _mm256_storeu_ps( &nppf[ y ], s_sum );
+        }
+    }
+}
+
+SEISMIC_EXEC_3D_FCT( avx2_fma_3d );
+#define SYM_KERNEL_CAP { .avx = 1, .avx2 = 1, .fma3 = 1 }
+SYM_KERNEL_3D( avx2_fma_3d, SYM_KERNEL_CAP, 0, 8 * sizeof(float) );
@@ -13,11 +13,11 @@ inline __attribute__((always_inline)) void kernel_avx_fma_unaligned( stack_t * d
     unsigned i, j;
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
-        unsigned r = i * data->height;
-        unsigned r_min1 = r - data->height;
-        unsigned r_min2 = r - (data->height * 2);
-        unsigned r_plus1 = r + data->height;
-        unsigned r_plus2 = r + (data->height * 2);
+        size_t r = (size_t)i * data->height;
+        size_t r_min1 = r - data->height;
+        size_t r_min2 = r - (data->height * 2);
+        size_t r_plus1 = r + data->height;
+        size_t r_plus2 = r + (data->height * 2);
         s_above1 = _mm256_loadu_ps( &(data->apf[ r -1]) );
         s_under1 = _mm256_loadu_ps( &(data->apf[ r +1]) );
         s_left1 = _mm256_loadu_ps( &(data->apf[ r_min1 ]) );
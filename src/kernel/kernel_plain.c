@@ -10,7 +10,7 @@ inline __attribute__((always_inline)) void kernel_plain_naiiv( stack_t * data )
     // spatial loop in z
     for (z=data->y_start; z<data->y_end; z+=data->y_offset) {
       // calculates the pressure field t+1
-      unsigned off = x * data->height + z;
+      size_t off = (size_t)x * data->height + z;
       data->nppf[ off ] = 2.0f*data->apf[ off ] - data->nppf[ off ] + data->vel[ off ] 
           *(-60.0f*data->apf[ off ]
             +16.0f*(data->apf[ off - 1 ]+data->apf[ off + 1 ]+data->apf[ off - data->height ]+data->apf[ off + data->height ] )
@@ -24,21 +24,25 @@ void seismic_exec_plain_naiiv( void * v )
 {
     stack_t * data = (stack_t*) v;
 
-    gettimeofday(&data->s, NULL);
+    // inserts the seismic pulse value in the desired position
+    data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0];
+
+    SEISMIC_LOOP_BEGIN( data );
 
     // time loop
     unsigned t, p;
     for (t = 0, p = 0; t < data->timesteps; t++)
     {
-        // inserts the seismic pulse value in the desired position
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t];
-
         kernel_plain_naiiv( data );
 
         // switch pointers instead of copying data
         float * tmp = data->nppf;
         data->nppf = data->apf;
         data->apf = tmp;
+
+        // + 1 because we add the pulse for the _next_ time step
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t+1];
+        SEISMIC_STEP( data );
         
         // shows one # at each 10% of the total processing time
         if( ! data->id && t == p )
@@ -49,7 +53,7 @@ void seismic_exec_plain_naiiv( void * v )
         }
     }
 
-    gettimeofday(&data->e, NULL);
+    SEISMIC_LOOP_END( data );
 }
 
 // function that implements the kernel of the seismic modeling algorithm
@@ -57,19 +61,17 @@ void seismic_exec_plain_naiiv_pthread( void * v )
 {
     stack_t * data = (stack_t*) v;
 
-    gettimeofday(&data->s, NULL);
+    // inserts the seismic pulse value in the desired position
+    if( data->set_pulse )
+      data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0];
+
+    SEISMIC_LOOP_BEGIN( data );
 
     // time loop
     unsigned t, p;
     for (t = 0, p = 0; t < data->timesteps; t++)
     {
-        BARRIER( data->barrier, data->id );
-
-        // inserts the seismic pulse value in the desired position
-        if( data->set_pulse )
-          data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t];
-
-        BARRIER( data->barrier, data->id );
+        SEISMIC_BARRIER( data );
 
         kernel_plain_naiiv( data );
 
@@ -77,6 +79,13 @@ void seismic_exec_plain_naiiv_pthread( void * v )
         float * tmp = data->nppf;
         data->nppf = data->apf;
         data->apf = tmp;
+
+        SEISMIC_BARRIER( data );
+
+        // + 1 because we add the pulse for the _next_ time step
+        if( data->set_pulse )
+          data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t+1];
+        SEISMIC_STEP( data );
         
         // shows one # at each 10% of the total processing time
         if( ! data->id && t == p )
@@ -87,7 +96,7 @@ void seismic_exec_plain_naiiv_pthread( void * v )
         }
     }
 
-    gettimeofday(&data->e, NULL);
+    SEISMIC_LOOP_END( data );
 
     if( data->id )
         pthread_exit( NULL );
@@ -160,7 +169,7 @@ inline __attribute__((always_inline)) void kernel_plain_opt_no_pulse( stack_t *
   float coeff_middle2 = -60.0f;
   float coeff_outer = -1.0f;
 
-  unsigned r = data->x_start * data->height + data->y_start;
+  size_t r = (size_t)data->x_start * data->height + data->y_start;
   unsigned offset = data->y_offset;
   float * NPPF = &data->nppf[ r ];
   float * VEL = &data->vel[ r ];
@@ -172,8 +181,10 @@ inline __attribute__((always_inline)) void kernel_plain_opt_no_pulse( stack_t *
   unsigned len_x = data->x_end - data->x_start;
   unsigned len_y = data->height - 4;
 
-//  if( ! len_y || ! len_x ) // checked in main!
+//  if( ! len_y ) // checked in main!
 //    return;
+  if( ! len_x ) // strip not reached yet, see SEISMIC_TRACK()
+    return;
 
   KERNEL_PLAIN_OPT_NO_PULSE( len_x );
 }
@@ -181,7 +192,7 @@ inline __attribute__((always_inline)) void kernel_plain_opt_no_pulse( stack_t *
 
 
 
-inline __attribute__((always_inline)) void kernel_plain_opt( stack_t * data, unsigned APF_offset, float** pulsevec )
+inline __attribute__((always_inline)) void kernel_plain_opt( stack_t * data, size_t APF_offset, float** pulsevec )
 {
   float coeff_middle = 2.0f;
   float coeff_inner = 16.0f;
@@ -189,7 +200,7 @@ inline __attribute__((always_inline)) void kernel_plain_opt( stack_t * data, uns
   float coeff_outer = -1.0f;
 
   float * NPPF_pulse = &data->nppf[APF_offset];
-  unsigned r = data->x_start * data->height + data->y_start;
+  size_t r = (size_t)data->x_start * data->height + data->y_start;
   unsigned offset = data->y_offset;
   float * NPPF = &data->nppf[ r ];
   float * VEL = &data->vel[ r ];
@@ -258,7 +269,7 @@ inline __attribute__((always_inline)) void kernel_plain_opt( stack_t * data, uns
   while( i > 0 );
 }
 
-inline __attribute__((always_inline)) void kernel_plain_opt_clopt( stack_t * data, unsigned APF_offset, float** pulsevec )
+inline __attribute__((always_inline)) void kernel_plain_opt_clopt( stack_t * data, size_t APF_offset, float** pulsevec )
 {
   float coeff_middle = 2.0f;
   float coeff_inner = 16.0f;
@@ -266,7 +277,7 @@ inline __attribute__((always_inline)) void kernel_plain_opt_clopt( stack_t * dat
   float coeff_outer = -1.0f;
 
   float * NPPF_pulse = &data->nppf[APF_offset];
-  unsigned r = data->x_start * data->height + data->y_start;
+  size_t r = (size_t)data->x_start * data->height + data->y_start;
   unsigned offset = data->y_offset;
   float * NPPF = &data->nppf[ r ];
   float * VEL = &data->vel[ r ];
@@ -343,11 +354,11 @@ void seismic_exec_plain_opt( void * v )
     stack_t * data = (stack_t*) v;
 
     float* pulsevec = &data->pulsevector[0];
-    unsigned APF_offset = data->x_pulse * data->height + data->y_pulse;
+    size_t APF_offset = (size_t)data->x_pulse * data->height + data->y_pulse;
 
     data->apf[APF_offset] += *(pulsevec++);
 
-    gettimeofday(&data->s, NULL);
+    SEISMIC_LOOP_BEGIN( data );
 
     // time loop
     unsigned t, r, t_tmp = 0;
@@ -361,6 +372,7 @@ void seismic_exec_plain_opt( void * v )
             float * tmp = data->nppf;
             data->nppf = data->apf;
             data->apf = tmp;
+            SEISMIC_STEP( data );
         }
 
         // shows one # at each 10% of the total processing time
@@ -377,9 +389,10 @@ void seismic_exec_plain_opt( void * v )
         float * tmp = data->nppf;
         data->nppf = data->apf;
         data->apf = tmp;
+        SEISMIC_STEP( data );
     }
 
-    gettimeofday(&data->e, NULL);
+    SEISMIC_LOOP_END( data );
 }
 
 // function that implements the kernel of the seismic modeling algorithm
@@ -388,7 +401,7 @@ void seismic_exec_plain_opt_pthread( void * v )
     stack_t * data = (stack_t*) v;
 
     float* pulsevec = &data->pulsevector[0];
-    unsigned APF_offset = data->x_pulse * data->height + data->y_pulse;
+    size_t APF_offset = (size_t)data->x_pulse * data->height + data->y_pulse;
 
     if( data->set_pulse )
         data->apf[APF_offset] += *(pulsevec++);
@@ -396,7 +409,7 @@ void seismic_exec_plain_opt_pthread( void * v )
     // start everything in parallel
     BARRIER( data->barrier, data->id );
 
-    gettimeofday(&data->s, NULL);
+    SEISMIC_LOOP_BEGIN( data );
 
     // time loop
     unsigned t = 0;
@@ -414,8 +427,9 @@ void seismic_exec_plain_opt_pthread( void * v )
                 float * tmp = data->nppf;
                 data->nppf = data->apf;
                 data->apf = tmp;
+                SEISMIC_STEP( data );
 
-                BARRIER( data->barrier, data->id );
+                SEISMIC_BARRIER( data );
             }
 
             // shows one # at each 10% of the total processing time
@@ -432,8 +446,9 @@ void seismic_exec_plain_opt_pthread( void * v )
             float * tmp = data->nppf;
             data->nppf = data->apf;
             data->apf = tmp;
+            SEISMIC_STEP( data );
 
-            BARRIER( data->barrier, data->id );
+            SEISMIC_BARRIER( data );
         }
     }
 #else
@@ -450,8 +465,9 @@ void seismic_exec_plain_opt_pthread( void * v )
                 float * tmp = data->nppf;
                 data->nppf = data->apf;
                 data->apf = tmp;
+                SEISMIC_STEP( data );
 
-                BARRIER( data->barrier, data->id );
+                SEISMIC_BARRIER( data );
             }
 
             // shows one # at each 10% of the total processing time
@@ -468,8 +484,9 @@ void seismic_exec_plain_opt_pthread( void * v )
             float * tmp = data->nppf;
             data->nppf = data->apf;
             data->apf = tmp;
+            SEISMIC_STEP( data );
 
-            BARRIER( data->barrier, data->id );
+            SEISMIC_BARRIER( data );
         }
     }
 #endif
@@ -482,12 +499,13 @@ void seismic_exec_plain_opt_pthread( void * v )
             float * tmp = data->nppf;
             data->nppf = data->apf;
             data->apf = tmp;
+            SEISMIC_STEP( data );
 
-            BARRIER( data->barrier, data->id );
+            SEISMIC_BARRIER( data );
         }
     }
 
-    gettimeofday(&data->e, NULL);
+    SEISMIC_LOOP_END( data );
 
     if( data->id )
         pthread_exit( NULL );
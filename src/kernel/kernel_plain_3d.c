@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include "kernel_3d.h"
+
+inline __attribute__((always_inline)) void kernel_plain_3d( stack_t * data )
+{
+  const ptrdiff_t col = data->height;
+  const ptrdiff_t plane = (ptrdiff_t)data->depth * data->height;
+  unsigned x, y, z;
+
+  KERNEL_3D_FOREACH_COLUMN( data, x, z ) {
+    size_t r = SEISMIC_OFFSET_3D( data, x, z, 0 );
+    const float * apf = &data->apf[ r ];
+    const float * vel = &data->vel[ r ];
+    float * nppf = &data->nppf[ r ];
+
+    // spatial loop in y, sums in the same order as the SIMD kernels
+    for (y=data->y_start; y<data->y_end; y++) {
+      float in = apf[ y - 1 ] + apf[ y + 1 ] + apf[ y - col ] + apf[ y + col ] + apf[ y - plane ] + apf[ y + plane ];
+      float out = apf[ y - 2 ] + apf[ y + 2 ] + apf[ y - 2 * col ] + apf[ y + 2 * col ] + apf[ y - 2 * plane ] + apf[ y + 2 * plane ];
+      nppf[ y ] = 2.0f * apf[ y ] - nppf[ y ] + vel[ y ] * (-90.0f * apf[ y ] + 16.0f * in - out);
+    }
+  }
+}
+
+SEISMIC_EXEC_3D_FCT( plain_3d );
+#define SYM_KERNEL_CAP {}
+SYM_KERNEL_3D( plain_3d, SYM_KERNEL_CAP, 0, 1 * sizeof(float) );
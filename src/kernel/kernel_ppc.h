@@ -27,12 +27,12 @@ void seismic_exec_##NAME( void* v ) \
     mergeHighLow = (vector unsigned char) \
         { 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 }; \
  \
-    data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+    data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t, r, t_tmp = 0; \
@@ -48,7 +48,8 @@ void seismic_exec_##NAME( void* v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+            SEISMIC_STEP( data ); \
         } \
  \
         /* shows one # at each 10% of the total processing time */ \
@@ -68,10 +69,11 @@ void seismic_exec_##NAME( void* v ) \
  \
         /* + 1 because we add the pulse for the _next_ time step */ \
         /* inserts the seismic pulse value in the desired position */ \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+        SEISMIC_STEP( data ); \
     } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
 } \
  \
  \
@@ -94,7 +96,7 @@ void seismic_exec_##NAME##_pthread(void * v ) \
         { 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 }; \
  \
     if( data->set_pulse ) \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
@@ -102,7 +104,7 @@ void seismic_exec_##NAME##_pthread(void * v ) \
     /* start everything in parallel */ \
     BARRIER( data->barrier, data->id ); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t; \
@@ -121,9 +123,10 @@ void seismic_exec_##NAME##_pthread(void * v ) \
  \
                 /* + 1 because we add the pulse for the _next_ time step */ \
                 /* inserts the seismic pulse value in the desired position */ \
-                data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                SEISMIC_STEP( data ); \
  \
-                BARRIER( data->barrier, data->id ); \
+                SEISMIC_BARRIER( data ); \
             } \
  \
             /* shows one # at each 10% of the total processing time */ \
@@ -143,9 +146,10 @@ void seismic_exec_##NAME##_pthread(void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
     } \
     else \
@@ -157,11 +161,12 @@ void seismic_exec_##NAME##_pthread(void * v ) \
             float * tmp = data->nppf; \
             data->nppf = data->apf; \
             data->apf = tmp; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
  \
     if( data->id ) \
         pthread_exit( NULL ); \
@@ -17,11 +17,11 @@ inline __attribute__((always_inline)) void kernel_sse_std( stack_t * data, __m12
     for (i=data->x_start; i<data->x_end; i++) {
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=data->y_offset) {
-            unsigned r = i * data->height + j;
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r = (size_t)i * data->height + j;
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
 
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_load_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -82,17 +82,17 @@ inline __attribute__((always_inline)) void kernel_sse_aligned( stack_t * data, _
     unsigned i, j;
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
         s_above1 = _mm_load_ps( &(data->apf[ r -4]) );
         s_actual = _mm_load_ps( &(data->apf[ r ]) );
         s_above2 = _mm_movelh_ps( _mm_movehl_ps( s_above1, s_above1), s_actual );
 
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4, r+=4) {
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
 
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_load_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -145,17 +145,17 @@ inline __attribute__((always_inline)) void kernel_sse_aligned_not_grouped( stack
     unsigned i, j;
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
         s_above1 = _mm_load_ps( &(data->apf[ r -4]) );
         s_actual = _mm_load_ps( &(data->apf[ r ]) );
         s_above2 = _mm_movelh_ps( _mm_movehl_ps( s_above1, s_above1), s_actual );
 
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4, r+=4) {
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
 
             // calculates the pressure field t+1
 //   _mm_prefetch( (const char*) &(data->apf[ r -4])  , _MM_HINT_T2); 
@@ -210,15 +210,15 @@ inline __attribute__((always_inline)) void kernel_sse_unaligned( stack_t * data,
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
 
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
         s_above2 = _mm_loadu_ps( &(data->apf[ r -2]) );
 
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4, r+=4) {
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
 
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_loadu_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -268,15 +268,15 @@ inline __attribute__((always_inline)) void kernel_sse_partial_aligned( stack_t *
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
 
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
         s_above2 = _mm_loadu_ps( &(data->apf[ r -2]) );
 
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4, r+=4) {
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
 
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_load_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -22,7 +22,9 @@ void seismic_exec_sse_##NAME( void * v ) \
     __m128 s_sixteen = _mm_loadu_ps( (const float *) &sixteen ); \
     __m128 s_sixty = _mm_loadu_ps( (const float *) &sixty ); \
  \
-    gettimeofday(&data->s, NULL); \
+    data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+ \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned r, t = 0; \
@@ -30,15 +32,17 @@ void seismic_exec_sse_##NAME( void * v ) \
     for( r = 0; r < 10; r++ ) { \
         for ( ; t < p * r; t++ ) \
         { \
-            /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t]; \
- \
             kernel_sse_##NAME( data, s_two, s_sixteen, s_sixty ); \
  \
             /* switch pointers instead of copying data */ \
             float * tmp = data->nppf; \
             data->nppf = data->apf; \
             data->apf = tmp; \
+ \
+            /* + 1 because we add the pulse for the _next_ time step */ \
+            /* inserts the seismic pulse value in the desired position */ \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t+1]; \
+            SEISMIC_STEP( data ); \
         } \
  \
         /* shows one # at each 10% of the total processing time */ \
@@ -49,18 +53,20 @@ void seismic_exec_sse_##NAME( void * v ) \
     } \
     for ( ; t < data->timesteps; t++ ) \
     { \
-        /* inserts the seismic pulse value in the desired position */ \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t]; \
- \
         kernel_sse_##NAME( data, s_two, s_sixteen, s_sixty ); \
  \
         /* switch pointers instead of copying data */ \
         float * tmp = data->nppf; \
         data->nppf = data->apf; \
         data->apf = tmp; \
+ \
+        /* + 1 because we add the pulse for the _next_ time step */ \
+        /* inserts the seismic pulse value in the desired position */ \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t+1]; \
+        SEISMIC_STEP( data ); \
     } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
 } \
  \
  \
@@ -78,7 +84,7 @@ void seismic_exec_sse_##NAME##_pthread(void * v ) \
     __m128 s_sixty = _mm_loadu_ps( (const float *) &sixty ); \
  \
     if( data->set_pulse ) \
-        data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
+        data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[0]; \
  \
     unsigned num_div = data->timesteps / 10; \
     unsigned num_mod = data->timesteps - (num_div * 10); \
@@ -86,7 +92,7 @@ void seismic_exec_sse_##NAME##_pthread(void * v ) \
     /* start everything in parallel */ \
     BARRIER( data->barrier, data->id ); \
  \
-    gettimeofday(&data->s, NULL); \
+    SEISMIC_LOOP_BEGIN( data ); \
  \
     /* time loop */ \
     unsigned t; \
@@ -105,9 +111,10 @@ void seismic_exec_sse_##NAME##_pthread(void * v ) \
  \
                 /* + 1 because we add the pulse for the _next_ time step */ \
                 /* inserts the seismic pulse value in the desired position */ \
-                data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+1]; \
+                SEISMIC_STEP( data ); \
  \
-                BARRIER( data->barrier, data->id ); \
+                SEISMIC_BARRIER( data ); \
             } \
  \
             /* shows one # at each 10% of the total processing time */ \
@@ -127,9 +134,10 @@ void seismic_exec_sse_##NAME##_pthread(void * v ) \
  \
             /* + 1 because we add the pulse for the _next_ time step */ \
             /* inserts the seismic pulse value in the desired position */ \
-            data->apf[data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            data->apf[(size_t)data->x_pulse * data->height + data->y_pulse] += data->pulsevector[t_tmp+t+1]; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
     } \
     else \
@@ -141,11 +149,12 @@ void seismic_exec_sse_##NAME##_pthread(void * v ) \
             float * tmp = data->nppf; \
             data->nppf = data->apf; \
             data->apf = tmp; \
+            SEISMIC_STEP( data ); \
  \
-            BARRIER( data->barrier, data->id ); \
+            SEISMIC_BARRIER( data ); \
         } \
  \
-    gettimeofday(&data->e, NULL); \
+    SEISMIC_LOOP_END( data ); \
  \
     if( data->id ) \
         pthread_exit( NULL ); \
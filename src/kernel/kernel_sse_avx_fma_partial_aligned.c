@@ -12,7 +12,7 @@ inline __attribute__((always_inline)) void kernel_sse_avx_fma_partial_aligned( s
     unsigned len_x = data->x_end - data->x_start;
     unsigned len_y = (data->y_end - data->y_start) / 4;
 
-    unsigned r = data->x_start * data->height + data->y_start;
+    size_t r = (size_t)data->x_start * data->height + data->y_start;
     float * NPPF = &data->nppf[ r ];
     float * VEL = &data->vel[ r ];
     float * APF = &data->apf[ r ];
@@ -89,7 +89,7 @@ inline __attribute__((always_inline)) void kernel_sse_avx_fma_partial_aligned_op
     unsigned len_x = data->x_end - data->x_start;
     unsigned len_y = (data->y_end - data->y_start) / 4;
 
-    unsigned r = data->x_start * data->height + data->y_start;
+    size_t r = (size_t)data->x_start * data->height + data->y_start;
     float * NPPF = &data->nppf[ r ];
     float * VEL = &data->vel[ r ];
     float * APF = &data->apf[ r ];
@@ -14,11 +14,11 @@ inline __attribute__((always_inline)) void kernel_sse_avx_partial_aligned( stack
     for (i=data->x_start; i<data->x_end; i++) {
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4) {
-            unsigned r = i * data->height + j;
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height * 2);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height * 2);
+            size_t r = (size_t)i * data->height + j;
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height * 2);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height * 2);
             
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_load_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -66,7 +66,7 @@ inline __attribute__((always_inline)) void kernel_sse_avx_partial_aligned_opt( s
     unsigned i, j;
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
 
         __m256 v_in = _mm256_loadu_ps( &data->apf[ r - 2 ] );
         s_above2 = _mm256_castps256_ps128( v_in ); //_mm_loadu_ps( &(data->apf[ r -2]) );
@@ -74,10 +74,10 @@ inline __attribute__((always_inline)) void kernel_sse_avx_partial_aligned_opt( s
 
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4, r+=4) {
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
             
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_load_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
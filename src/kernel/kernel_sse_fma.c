@@ -20,11 +20,11 @@ inline __attribute__((always_inline)) void kernel_sse_fma_std( stack_t * data, _
     for (i=data->x_start; i<data->x_end; i++) {
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=data->y_offset) {
-            unsigned r = i * data->height + j;
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r = (size_t)i * data->height + j;
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
 
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_load_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -100,11 +100,11 @@ inline __attribute__((always_inline)) void kernel_sse_fma_aligned( stack_t * dat
     for (i=data->x_start; i<data->x_end; i++) {
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4) {
-            unsigned r = i * data->height + j;
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height * 2);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height * 2);
+            size_t r = (size_t)i * data->height + j;
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height * 2);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height * 2);
             
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_load_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -159,11 +159,11 @@ inline __attribute__((always_inline)) void kernel_sse_fma_aligned_not_grouped( s
     for (i=data->x_start; i<data->x_end; i++) {
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4) {
-            unsigned r = i * data->height + j;
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height * 2);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height * 2);
+            size_t r = (size_t)i * data->height + j;
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height * 2);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height * 2);
             
             // calculates the pressure field t+1
 //   _mm_prefetch( (const char*) &(data->apf[ r -4])  , _MM_HINT_T2); 
@@ -218,16 +218,16 @@ inline __attribute__((always_inline)) void kernel_sse_fma_unaligned( stack_t * d
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
 
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
         s_above2 = _mm_loadu_ps( &(data->apf[ r -2]) );
 
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4) {
-            unsigned r = i * data->height + j;
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height * 2);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height * 2);
+            size_t r = (size_t)i * data->height + j;
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height * 2);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height * 2);
             
             // calculates the pressure field t+1
             s_ppf_aligned = _mm_loadu_ps( &(data->nppf[ r ]) ); // align it to get _load_ps
@@ -277,7 +277,7 @@ inline __attribute__((always_inline)) void kernel_sse_fma_partial_aligned( stack
     unsigned len_x = data->x_end - data->x_start;
     unsigned len_y = (data->y_end - data->y_start)/4;
 
-    unsigned r = data->x_start * data->height + data->y_start;
+    size_t r = (size_t)data->x_start * data->height + data->y_start;
     float * NPPF = &data->nppf[ r ];
     float * VEL = &data->vel[ r ];
     float * APF = &data->apf[ r ];
@@ -287,8 +287,10 @@ inline __attribute__((always_inline)) void kernel_sse_fma_partial_aligned( stack
     float * APF_min2 = APF_min1 - data->height;
     APF += 2;
 
-//  if( ! len_y || ! len_x ) // checked in main!
+//  if( ! len_y ) // checked in main!
 //    return;
+    if( ! len_x ) // strip not reached yet, see SEISMIC_TRACK()
+        return;
 
     // spatial loop in x
     unsigned i = len_x;
@@ -15,17 +15,17 @@ inline __attribute__((always_inline)) void kernel_vmx_aligned( stack_t * data, v
     // spatial loop in x
     for (i=data->x_start; i<data->x_end; i++) {
     
-        unsigned r = i * data->height + data->y_start;
+        size_t r = (size_t)i * data->height + data->y_start;
         s_above1 = vec_ld(0, &(data->apf[ r -4]) );
         s_actual = vec_ld(0, &(data->apf[ r ]) );
         s_above2 = vec_perm(s_above1, s_actual, mergeHighLow);
         
         // spatial loop in y
         for (j=data->y_start; j<data->y_end; j+=4, r+=4) {
-            unsigned r_min1 = r - data->height;
-            unsigned r_min2 = r - (data->height << 1);
-            unsigned r_plus1 = r + data->height;
-            unsigned r_plus2 = r + (data->height << 1);
+            size_t r_min1 = r - data->height;
+            size_t r_min2 = r - (data->height << 1);
+            size_t r_plus1 = r + data->height;
+            size_t r_plus2 = r + (data->height << 1);
             
             // calculates the pressure field t+1
             s_under1 = vec_ld(0, &(data->apf[ r +4]) );
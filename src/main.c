@@ -5,79 +5,254 @@
 #include <sched.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <pthread.h>
 #include "config.h"
 #include "kernel.h"
+#include "kernel_3d.h"
 #include "seismic.h"
 #include "visualize.h"
+#include "snapshot.h"
+#include "movie.h"
+#include "snapfile.h"
+#include "checkpoint.h"
+#include "shmring.h"
+#include "receiver.h"
+#include "inject.h"
+#include "cpml.h"
+#include "velocity.h"
+#include "outofcore.h"
+#include "bench.h"
+#include "perf.h"
+#include "prof.h"
+#include "roofline.h"
+#include "trace.h"
 #include "barrier/barrier.h"
 
-int main( int argc, char * argv[] ) {
+void seismic_run( config_t * config, stack_t * data, void (* func)(void *) ) {
+  unsigned cores = get_num_cores();
 
-  config_t config;
-  get_config( argc, argv, &config );
-  print_config( &config );
+  pthread_attr_t attr;
+  pthread_attr_init( &attr );
+  if( pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_JOINABLE ) ) {
+    printf("WARNING: could not set PTHREAD_CREATE_JOINABLE");
+  }
 
-  if(config.verbose)
-    printf("allocate and initialize seismic data\n");
-  float *APF, *VEL, *NPPF, *pulsevector;
-  if( alloc_seismic_buffers( config.width, config.height, config.timesteps, config.variant->alignment, &VEL, &APF, &NPPF, &pulsevector ) ) {
-    printf("allocation failure\n");
-    exit(EXIT_FAILURE);
+  if( pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED) ) {
+    printf("WARNING: could not set PTHREAD_EXPLICIT_SCHED");
   }
-  init_seismic_buffers( config.width, config.height, config.timesteps, VEL, APF, NPPF, pulsevector );
 
+  pthread_t * threads = (pthread_t*) malloc ( sizeof(pthread_t) * (config->threads - 1) );
+  cpu_set_t cpuset;
+  unsigned i;
+  for( i = 0; i < config->threads - 1; i++ ) {
+    CPU_ZERO(&cpuset); // first zero
+    CPU_SET((i+1) % cores, &cpuset); // set only the specific one
 
-  struct timeval t1, t2;
-  gettimeofday(&t1, NULL);
+    if( pthread_create( &threads[i], &attr, (void * (*)(void *))func, (void*) &data[i + 1] ) ) {
+      printf("ERROR: Couldn't create thread %u of %u threads!!\nExiting...\n", i+1, config->threads);
+      exit( EXIT_FAILURE );
+    }
 
-  BARRIER_TYPE barrier;
-  BARRIER_INIT( &barrier, config.threads );
+    if( pthread_setaffinity_np(threads[i], sizeof(cpu_set_t), &cpuset)
+        && config->verbose ) {
+      printf("WARNING: Couldn't pin thread %u to a single core! "
+             "Performance may suck...\n", i+1);
+    }
+  }
+
+  // execute code with this thread here ...
+  CPU_ZERO(&cpuset); // first zero
+  CPU_SET(0, &cpuset); // set only the specific one
+  if( pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)
+      && config->verbose ) {
+    printf("WARNING: Couldn't pin thread %u to a single core! "
+           "Performance may suck...\n", i+1);
+  }
+  func( &data[0] );
+
+  for( i = 0; i < config->threads - 1; i++ ) {
+    if( pthread_join( threads[i], NULL ) ) {
+      printf("ERROR: Couldn't join thread %u of %u threads!!\nExiting...\n", i+1, config->threads );
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  pthread_attr_destroy( &attr );
+  free( threads );
+}
 
+// the strips (3D: blocks) of the threads, for config->variant
+void seismic_setup( config_t * config, stack_t * data, BARRIER_TYPE * barrier, float * APF, float * NPPF, float * VEL, float * pulsevector ) {
   unsigned t_id = 0;
-  unsigned width_part = (config.width - 4) / config.threads;
-  if( config.variant->alignment )
-    width_part += (config.variant->alignment / sizeof(float)) - (width_part % config.variant->alignment); // round up to next alignment
+  unsigned width_part = (config->width - 4) / config->threads;
+  if( config->variant->alignment )
+    width_part += (config->variant->alignment / sizeof(float)) - (width_part % config->variant->alignment); // round up to next alignment
+
+  // 3D: a grid of pz columns (z) times py rows (y), rows in whole vectors
+  unsigned pz = config->threads, py = 1;
+  while( pz > config->depth - 4 && ! (pz & 0x1) ) {
+    pz >>= 1;
+    py <<= 1;
+  }
+  unsigned vec = config->variant->vectorwidth / sizeof(float);
+  unsigned z_part = (config->depth - 4) / pz;
+  unsigned y_part = ((config->height - 4) / vec / py) * vec;
 
-  stack_t * data = (stack_t*) malloc ( sizeof(stack_t) * config.threads );
-  for( t_id = 0; t_id < config.threads; t_id++ ) {
+  for( t_id = 0; t_id < config->threads; t_id++ ) {
     data[t_id].id = t_id;
     data[t_id].apf = APF;
     data[t_id].nppf = NPPF;
     data[t_id].vel = VEL;
     data[t_id].pulsevector = pulsevector;
-    data[t_id].width = config.width;
-    data[t_id].height = config.height;
-    data[t_id].timesteps = config.timesteps;
-    data[t_id].x_pulse = config.pulseX;
-    data[t_id].y_pulse = config.pulseY;
-    data[t_id].barrier = &barrier;
-    data[t_id].y_offset = (!config.variant->alignment) ? 1 : (config.variant->alignment / sizeof(float));
+    data[t_id].width = config->width;
+    data[t_id].height = config->height;
+    data[t_id].timesteps = config->timesteps;
+    data[t_id].x_pulse = config->pulseX;
+    data[t_id].y_pulse = config->pulseY;
+    data[t_id].z_pulse = config->pulseZ;
+    data[t_id].depth = config->depth;
+    data[t_id].z_start = 0;
+    data[t_id].z_end = data[t_id].z_block = 1;
+    data[t_id].barrier = barrier;
+    data[t_id].y_offset = (!config->variant->alignment) ? 1 : (config->variant->alignment / sizeof(float));
 
     data[t_id].x_start = 2 + t_id * width_part;
-    if( t_id + 1 == config.threads ) 
-      data[t_id].x_end = config.width - 2;
+    if( t_id + 1 == config->threads ) 
+      data[t_id].x_end = config->width - 2;
     else
       data[t_id].x_end = data[t_id].x_start + width_part;
 
     data[t_id].y_start = 2;
-    data[t_id].y_end = config.height - 2;
+    data[t_id].y_end = config->height - 2;
 
     data[t_id].set_pulse = (data[t_id].x_start <= data[t_id].x_pulse && data[t_id].x_pulse < data[t_id].x_end);
-    data[t_id].clopt = config.clopt;
+    data[t_id].clopt = config->clopt;
+
+    data[t_id].step = 0;
+    data[t_id].hooks = 0;
+    data[t_id].store = NULL;
+    data[t_id].keep = 0;
+    data[t_id].movie = NULL;
+    data[t_id].every = 0;
+    data[t_id].ckpt = NULL;
+    data[t_id].ckpt_every = 0;
+    data[t_id].shm = NULL;
+    data[t_id].shm_every = 0;
+    data[t_id].recv = NULL;
+    data[t_id].r_start = data[t_id].r_end = 0;
+    data[t_id].inj = NULL;
+    data[t_id].i_start = data[t_id].i_end = 0;
+    data[t_id].pml = NULL;
+    data[t_id].model = NULL;
+    data[t_id].perf = NULL;
+    data[t_id].prof = NULL;
 
     // Cacheline optimized
-    if( config.clopt
-        && ( ! strcmp( "plain_naiiv", config.variant->name )
-             || ! strcmp( "plain_opt", config.variant->name )
-          /* || ! strcmp( "sse_std", config.variant->name ) */ ) ) {
+    if( config->clopt
+        && ( ! strcmp( "plain_naiiv", config->variant->name )
+             || ! strcmp( "plain_opt", config->variant->name )
+          /* || ! strcmp( "sse_std", config->variant->name ) */ ) ) {
       data[t_id].x_start = 2;
-      data[t_id].x_end = config.width - 2;
-      data[t_id].y_start = 2 + t_id * ( config.variant->alignment ? (config.variant->alignment / sizeof(float)) : 1 );
-      data[t_id].y_end = config.height - 2;
-      data[t_id].y_offset *= config.threads;
+      data[t_id].x_end = config->width - 2;
+      data[t_id].y_start = 2 + t_id * ( config->variant->alignment ? (config->variant->alignment / sizeof(float)) : 1 );
+      data[t_id].y_end = config->height - 2;
+      data[t_id].y_offset *= config->threads;
     }
+
+    if( config->depth > 1 ) {
+      unsigned tz = t_id % pz, ty = t_id / pz;
+      data[t_id].x_start = 2;
+      data[t_id].x_end = config->width - 2;
+      data[t_id].z_start = 2 + tz * z_part;
+      data[t_id].z_end = tz + 1 == pz ? config->depth - 2 : data[t_id].z_start + z_part;
+      data[t_id].y_start = 2 + ty * y_part;
+      data[t_id].y_end = ty + 1 == py ? config->height - 2 : data[t_id].y_start + y_part;
+      data[t_id].set_pulse = (data[t_id].z_start <= config->pulseZ && config->pulseZ < data[t_id].z_end
+                              && data[t_id].y_start <= config->pulseY && config->pulseY < data[t_id].y_end);
+
+      // the five planes of a z-block need to fit into the cache
+      unsigned long plane = (unsigned long)(data[t_id].y_end - data[t_id].y_start + 4) * sizeof(float) * 5;
+      data[t_id].z_block = plane ? KERNEL_3D_CACHE / plane : 1;
+      if( ! data[t_id].z_block )
+        data[t_id].z_block = 1;
+    }
+
+    data[t_id].strip_x_start = data[t_id].x_start;
+    data[t_id].strip_x_end = data[t_id].x_end;
+    data[t_id].reach = 0;
+    data[t_id].act_start = data[t_id].act_end = 0;
   }
+}
+
+int main( int argc, char * argv[] ) {
+
+  config_t config;
+  get_config( argc, argv, &config );
+  print_config( &config );
+
+  // before any writer or worker thread claims its track
+  if( config.timeline && (seismic_trace = trace_create( config.threads )) == NULL ) {
+    printf("allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if(config.verbose)
+    printf("allocate and initialize seismic data\n");
+  float *APF, *VEL, *NPPF, *pulsevector;
+  ooc_t * ooc = NULL;
+  if( config.ooc ) {
+    // initialised through the mapped files, like in memory
+    ooc = ooc_create( config.ooc, config.width, config.height, config.timesteps, config.ooc_cols, config.ooc_steps );
+    pulsevector = (float*) malloc( (config.timesteps + 1) * sizeof(float) );
+    if( ooc == NULL || pulsevector == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+    APF = ooc->apf;
+    NPPF = ooc->nppf;
+    VEL = ooc->vel;
+  }
+  else if( config.mapped ) {
+    // unaligned kernels only, VEL stays on the heap
+    VEL = (float*) malloc( (unsigned long)config.width * config.depth * config.height * sizeof(float) );
+    pulsevector = (float*) malloc( (config.timesteps + 1) * sizeof(float) );
+    if( VEL == NULL || pulsevector == NULL || map_matrices( &config, &APF, &NPPF ) ) {
+      fprintf(stderr, "ERROR: could not map the output '%s'\n", config.ofile);
+      exit(EXIT_FAILURE);
+    }
+  }
+  // 3D: depth columns (z) of height values (y) per x
+  else if( alloc_seismic_buffers( config.width * config.depth, config.height, config.timesteps, config.variant->alignment, &VEL, &APF, &NPPF, &pulsevector ) ) {
+    printf("allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+  velocity_t * model = NULL;
+  if( config.velocity ) {
+    float h = SEISMIC_H, dt = SEISMIC_DT;
+    model = velocity_open( config.velocity, config.model_width, config.model_height, config.randbound, config.model_x0, (dt*dt)/(h*h*12.0f) );
+    if( model == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  // a model is converted by the threads later on, each its own strip
+  // mapped frames are zero already, see map_matrices()
+  init_seismic_buffers( config.width * config.depth, config.height, config.timesteps, model ? NULL : VEL,
+                        config.mapped ? NULL : APF, config.mapped ? NULL : NPPF, pulsevector, config.randbound );
+
+
+  struct timeval t1, t2;
+  gettimeofday(&t1, NULL);
+
+  BARRIER_TYPE barrier;
+  BARRIER_INIT( &barrier, config.threads );
+
+  unsigned t_id = 0;
+  stack_t * data = (stack_t*) malloc ( sizeof(stack_t) * config.threads );
+  seismic_setup( &config, data, &barrier, APF, NPPF, VEL, pulsevector );
+  for( t_id = 0; t_id < config.threads; t_id++ )
+    data[t_id].model = model;
 
   void (* func)(void *) = config.variant->fnc_sgl;
   if( config.threads != 1 )
@@ -95,58 +270,328 @@ int main( int argc, char * argv[] ) {
            "         then cores available (%u vs %u).\n"
            "         performance may suffer.\n", config.threads, cores);
 
-  if(config.verbose)
-    printf("processing...\n");
+  if( model ) {
+    struct timeval v1, v2;
+    gettimeofday(&v1, NULL);
 
-  pthread_attr_t attr;
-  pthread_attr_init( &attr );
-  if( pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_JOINABLE ) ) {
-    printf("WARNING: could not set PTHREAD_CREATE_JOINABLE");
+    // same threads and pinning as the run, hence first touch of VEL happens next to the user
+    if( config.clopt )
+      velocity_convert( &data[0] ); // strips are interleaved rows
+    else
+      seismic_run( &config, data, velocity_convert );
+
+    // beyond c_max the courant value is exceeded and the propagation blows up
+    unsigned long i, n = (unsigned long)config.width * config.depth * config.height;
+    for( i = 0; i < n; i++ ) {
+      if( VEL[ i ] > SEISMIC_VEL_MAX * 1.00001f ) {
+        fprintf(stderr, "ERROR: velocity model '%s' exceeds %u m/s\n", config.velocity, SEISMIC_C_MAX);
+        exit(EXIT_FAILURE);
+      }
+    }
+    if( config.randbound )
+      init_seismic_randbound( config.width, config.height, VEL, config.randbound, SEISMIC_VEL_MAX );
+
+    velocity_close( model );
+    for( t_id = 0; t_id < config.threads; t_id++ )
+      data[t_id].model = NULL;
+
+    gettimeofday(&v2, NULL);
+    if(config.verbose)
+      printf("velocity model converted in %.2f ms\n", (v2.tv_sec - v1.tv_sec) * 1000.0 + (v2.tv_usec - v1.tv_usec) / 1000.0 );
+    gettimeofday(&t1, NULL); // not part of the run
   }
 
-  if( pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED) ) {
-    printf("WARNING: could not set PTHREAD_EXPLICIT_SCHED");
+  // ceilings of this machine, with the threads of the run
+  roofline_t roof;
+  if( config.roofline ) {
+    if(config.verbose)
+      printf("measure the roofline\n");
+    roofline_measure( &config, data, &roof );
+    roofline_print( &roof );
   }
 
-  pthread_t * threads = (pthread_t*) malloc ( sizeof(pthread_t) * (config.threads - 1) );
-  cpu_set_t cpuset;
-  unsigned i;
-  for( i = 0; i < config.threads - 1; i++ ) {
-    CPU_ZERO(&cpuset); // first zero
-    CPU_SET((i+1) % cores, &cpuset); // set only the specific one
+  if( config.bench ) {
+    bench_run( &config, data, &barrier, APF, NPPF, VEL, pulsevector, config.roofline ? &roof : NULL );
 
-    if( pthread_create( &threads[i], &attr, (void * (*)(void *))func, (void*) &data[i + 1] ) ) {
-      printf("ERROR: Couldn't create thread %u of %u threads!!\nExiting...\n", i+1, config.threads);
-      exit( EXIT_FAILURE );
+    unsigned alignment = config.variant->alignment ? (config.variant->alignment - 2 * sizeof(float)) : 0;
+    free( ((char*)APF) - alignment );
+    free( ((char*)NPPF) - alignment );
+    free( ((char*)VEL) - alignment );
+    free( pulsevector );
+    free( data );
+    return 0;
+  }
+
+  snapshot_store_t * store = NULL;
+  if( config.keep ) {
+    unsigned max_cols = 0;
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      if( data[t_id].x_end - data[t_id].x_start + 2 > max_cols )
+        max_cols = data[t_id].x_end - data[t_id].x_start + 2;
     }
 
-    if( pthread_setaffinity_np(threads[i], sizeof(cpu_set_t), &cpuset)
-        && config.verbose ) {
-      printf("WARNING: Couldn't pin thread %u to a single core! "
-             "Performance may suck...\n", i+1);
+    // compress on the cores not used for computation
+    store = snapshot_store_create( config.width, config.height, config.timesteps / config.keep,
+                                   config.threads, max_cols, config.compress,
+                                   cores > config.threads ? cores - config.threads : 1 );
+    if( store == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].store = store;
+      data[t_id].keep = config.keep;
+      data[t_id].hooks = 1;
     }
   }
 
-  // execute code with this thread here ...
-  CPU_ZERO(&cpuset); // first zero
-  CPU_SET(0, &cpuset); // set only the specific one
-  if( pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)
-      && config.verbose ) {
-    printf("WARNING: Couldn't pin thread %u to a single core! "
-           "Performance may suck...\n", i+1);
+  movie_t * movie = NULL;
+  if( config.every ) {
+    snapfile_header_t snap;
+    snapfile_init( &snap, config.width, config.height, config.timesteps / config.every, config.every, config.variant->name, SEISMIC_DT, SEISMIC_H );
+    snap.randbound = config.randbound;
+    snap.model_x0 = config.model_x0;
+    movie = movie_create( config.mfile, config.width, config.height, config.timesteps / config.every, config.threads,
+                          snapfile_is( config.mfile ) ? &snap : NULL );
+    if( movie == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].movie = movie;
+      data[t_id].every = config.every;
+      data[t_id].hooks = 1;
+    }
   }
-  func( &data[0] );
 
-  for( i = 0; i < config.threads - 1; i++ ) {
-    if( pthread_join( threads[i], NULL ) ) {
-      printf("ERROR: Couldn't join thread %u of %u threads!!\nExiting...\n", i+1, config.threads );
-      exit( EXIT_FAILURE );
+  cpml_t * pml = NULL;
+  if( config.cpml ) {
+    // the derivative of psi along x must not cross strips
+    if( STRIP_X_END( &data[0] ) < 2 + config.cpml + 2
+        || STRIP_X_START( &data[config.threads - 1] ) + config.cpml + 4 > config.width ) {
+      fprintf(stderr, "ERROR: cpml (%u) needs to fit into the outer strips, use less threads\n", config.cpml);
+      exit(EXIT_FAILURE);
+    }
+
+    float vel_max = 0.0f;
+    unsigned long i;
+    for( i = 0; i < (unsigned long)config.width * config.height; i++ )
+      if( VEL[ i ] > vel_max )
+        vel_max = VEL[ i ];
+
+    // vel = v^2 dt^2 / (12 h^2)
+    pml = cpml_create( config.width, config.height, config.cpml,
+                       sqrtf( vel_max * 12.0f ) * SEISMIC_H / SEISMIC_DT,
+                       SEISMIC_H, SEISMIC_DT, SEISMIC_FPEAK );
+    if( pml == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].pml = pml;
+      data[t_id].hooks = 1;
     }
   }
 
-  gettimeofday(&t2, NULL);
+  receiver_t * recv = NULL;
+  if( config.receivers ) {
+    recv = receiver_create( config.receivers, config.width, config.height, config.randbound, config.model_x0,
+                            config.timesteps, config.subsample, SEISMIC_DT );
+    if( recv == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
 
-  pthread_attr_destroy( &attr );
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].recv = recv;
+      receiver_range( recv, STRIP_X_START( &data[t_id] ), STRIP_X_END( &data[t_id] ),
+                      &data[t_id].r_start, &data[t_id].r_end );
+      data[t_id].hooks = 1;
+    }
+  }
+
+  inject_t * inj = NULL;
+  if( config.inject || config.sources ) {
+    if( config.inject )
+      inj = inject_create( config.inject, config.width, config.height, config.randbound, config.model_x0,
+                           config.timesteps, SEISMIC_H, SEISMIC_DT );
+    else
+      inj = inject_sources( config.sources, config.width, config.height, config.randbound, config.model_x0,
+                            config.timesteps, pulsevector, config.encode );
+    if( inj == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+    if(config.verbose)
+      printf("inject %u grid points instead of the pulse\n", inj->count);
+
+    // the traces (or sources) replace the pulse, first row goes into the initial frame
+    memset( pulsevector, 0, (config.timesteps + 1) * sizeof(float) );
+    INJECT_APPLY( inj, 0, 0, inj->count, APF );
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].inj = inj;
+      inject_range( inj, STRIP_X_START( &data[t_id] ), STRIP_X_END( &data[t_id] ),
+                    &data[t_id].i_start, &data[t_id].i_end );
+      data[t_id].hooks = 1;
+    }
+  }
+
+  if( recv ) {
+    // first sample is the initial frame, incl. the pulse the kernels add before their first timestep
+    unsigned long pulse = (unsigned long)config.pulseX * config.height + config.pulseY;
+    unsigned i;
+    RECEIVER_RECORD( recv, 0, 0, recv->count, APF );
+    for( i = 0; i < recv->count; i++ )
+      if( recv->offset[ i ] == pulse )
+        recv->trace[ (unsigned long)i * recv->samples ] += pulsevector[ 0 ];
+  }
+
+  if( config.track ) {
+    // initially, only the pulse and the injected points are non-zero
+    unsigned act_start = config.pulseX, act_end = config.pulseX + 1;
+    unsigned i;
+    for( i = 0; inj && i < inj->count; i++ ) {
+      if( inj->x[ i ] < act_start )
+        act_start = inj->x[ i ];
+      if( inj->x[ i ] + 1 > act_end )
+        act_end = inj->x[ i ] + 1;
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      // the stencil reaches 2 columns, psi of the cpml 2 more
+      data[t_id].reach = pml ? 4 : 2;
+      data[t_id].act_start = act_start;
+      data[t_id].act_end = act_end;
+      SEISMIC_TRACK( &data[t_id] );
+    }
+    if(config.verbose)
+      printf("track columns %u to %u, growing by %u per timestep\n", data[0].act_start, data[0].act_end, data[0].reach);
+  }
+
+  // what a checkpoint is bound to, besides the kernel and the grid
+  checkpoint_header_t ckhdr;
+  memset( &ckhdr, 0, sizeof(ckhdr) );
+  memcpy( ckhdr.magic, CHECKPOINT_MAGIC, sizeof(ckhdr.magic) );
+  ckhdr.version = CHECKPOINT_VERSION;
+  ckhdr.width = config.width;
+  ckhdr.height = config.height;
+  ckhdr.timesteps = config.timesteps;
+  ckhdr.pulseX = config.pulseX;
+  ckhdr.pulseY = config.pulseY;
+  ckhdr.randbound = config.randbound;
+  ckhdr.model_x0 = config.model_x0;
+  ckhdr.encode = config.encode;
+  strncpy( ckhdr.kernel, config.variant->name, sizeof(ckhdr.kernel) - 1 );
+  strncpy( ckhdr.velocity, config.velocity ? config.velocity : "", sizeof(ckhdr.velocity) - 1 );
+  strncpy( ckhdr.inject, config.inject ? config.inject : "", sizeof(ckhdr.inject) - 1 );
+  strncpy( ckhdr.sources, config.sources ? config.sources : "", sizeof(ckhdr.sources) - 1 );
+
+  unsigned start = 0;
+  float * spulsevector = NULL;
+  if( config.restart ) {
+    int step = checkpoint_load( config.restart, &ckhdr, APF, NPPF );
+    if( step < 0 )
+      exit(EXIT_FAILURE);
+    start = step;
+
+    // the pulses from timestep start on, the one of start is in the frame already (x + -0.0f == x)
+    spulsevector = (float*) malloc( (config.timesteps - start + 1) * sizeof(float) );
+    if( spulsevector == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+    spulsevector[ 0 ] = -0.0f;
+    memcpy( &spulsevector[ 1 ], &pulsevector[ start + 1 ], (config.timesteps - start) * sizeof(float) );
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].pulsevector = spulsevector;
+      data[t_id].timesteps = config.timesteps - start;
+      data[t_id].step = start;
+      // the whole matrix may be active already
+      data[t_id].x_start = data[t_id].strip_x_start;
+      data[t_id].x_end = data[t_id].strip_x_end;
+      data[t_id].reach = 0;
+    }
+
+    // write_matrice() and show_ascii() pick the frame by the parity of timesteps
+    if( start & 0x1 ) {
+      float * tmp = APF;
+      APF = NPPF;
+      NPPF = tmp;
+    }
+    if(config.verbose)
+      printf("restart from timestep %u of %s\n", start, config.restart);
+  }
+
+  checkpoint_t * ckpt = NULL;
+  if( config.ckpt_every ) {
+    ckpt = checkpoint_create( config.cfile, &ckhdr, config.ckpt_every, start, config.threads );
+    if( ckpt == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].ckpt = ckpt;
+      data[t_id].ckpt_every = config.ckpt_every;
+      data[t_id].hooks = 1;
+    }
+  }
+
+  shmring_t * shm = NULL;
+  if( config.shm_every ) {
+    shm = shmring_create( config.shm, config.width, config.height, config.shm_every, config.timesteps / config.shm_every, config.threads );
+    if( shm == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].shm = shm;
+      data[t_id].shm_every = config.shm_every;
+      data[t_id].hooks = 1;
+    }
+  }
+
+  perf_t * perf = NULL;
+  if( config.perf ) {
+    perf = perf_create( config.threads, config.perf > 1 );
+    if( perf == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ )
+      data[t_id].perf = perf;
+  }
+
+  prof_t * prof = NULL;
+  if( config.imbalance ) {
+    // reverse: both time loops
+    prof = prof_create( config.threads, config.timesteps * (config.reverse ? 2 : 1) );
+    if( prof == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for( t_id = 0; t_id < config.threads; t_id++ )
+      data[t_id].prof = prof;
+  }
+
+  if(config.verbose)
+    printf("processing...\n");
+
+  if( ooc )
+    ooc_run( ooc, &config, data );
+  else
+    seismic_run( &config, data, func );
+
+  gettimeofday(&t2, NULL);
 
   if(config.verbose) {
     printf("\nend process!\n");
@@ -156,28 +601,298 @@ int main( int argc, char * argv[] ) {
     double elapsedTimeInner = (data[0].e.tv_sec - data[0].s.tv_sec) * 1000.0 + (data[0].e.tv_usec - data[0].s.tv_usec) / 1000.0; // ms
 
     printf("\n");
-    printf("(ID=0Z): OUTER  = %.2f ms (GFLOPS: %.2f)\n", elapsedTimeOuter, config.GFLOP/elapsedTimeOuter );
-    printf("(ID=0Z): INNER  = %.2f ms (GFLOPS: %.2f)\n", elapsedTimeInner, config.GFLOP/elapsedTimeInner );
+    double GFLOP = config.GFLOP * (config.timesteps - start) / config.timesteps; // restart: the remaining timesteps only
+    printf("(ID=0Z): OUTER  = %.2f ms (GFLOPS: %.2f)\n", elapsedTimeOuter, GFLOP/elapsedTimeOuter );
+    printf("(ID=0Z): INNER  = %.2f ms (GFLOPS: %.2f)\n", elapsedTimeInner, GFLOP/elapsedTimeInner );
   }
   else
     printf("\n");
 
+  if( config.roofline && ! ooc ) {
+    double GFLOP = config.GFLOP * (config.timesteps - start) / config.timesteps;
+    double elapsedTimeInner = (data[0].e.tv_sec - data[0].s.tv_sec) * 1000.0 + (data[0].e.tv_usec - data[0].s.tv_usec) / 1000.0; // ms
+    roofline_kernel( &roof, config.variant, GFLOP/elapsedTimeInner );
+  }
+
+  if( ooc ) {
+    if(config.verbose)
+      printf("(ID=0Z): OOC    = %u passes x %u blocks, read %.2f GB, written %.2f GB, I/O wait %.2f ms\n",
+             ooc->passes, ooc->blocks, ooc->read / 1073741824.0, ooc->written / 1073741824.0, ooc->wait );
+
+    // write_matrice() and show_ascii() pick the frame by the parity of timesteps
+    APF = ooc->apf;
+    NPPF = ooc->nppf;
+    if( config.timesteps & 0x1 ) {
+      APF = ooc->nppf;
+      NPPF = ooc->apf;
+    }
+  }
+
+  if( store ) {
+    snapshot_store_wait( store );
+
+    if(config.verbose)
+      printf("(ID=0Z): KEPT   = %u frames, %.2f MB -> %.2f MB (ratio: %.2f)\n",
+             store->frames, store->raw / 1048576.0, store->packed / 1048576.0,
+             store->packed ? (double)store->raw / (double)store->packed : 0.0 );
+
+    // the last kept frame is the final one, if keep divides timesteps: it
+    // has to come back exactly (lossless) or within the bound
+    if( store->frames && ! (config.timesteps % config.keep) ) {
+      float * frame = (float*) calloc( (unsigned long)config.width * config.height, sizeof(float) );
+      if( frame == NULL ) {
+        printf("allocation failure\n");
+        exit(EXIT_FAILURE);
+      }
+      snapshot_store_get( store, store->frames - 1, frame );
+
+      float err = 0.0f;
+      unsigned long i;
+      for( i = 0; i < (unsigned long)config.width * config.height; i++ ) {
+        float e = fabsf( frame[ i ] - data[0].apf[ i ] );
+        if( e > err || e != e )
+          err = e;
+      }
+      free( frame );
+      if(config.verbose)
+        printf("(ID=0Z): KEPT   = max. error %e (bound: %e)\n", err, config.compress );
+      if( ! (err <= config.compress) ) {
+        fprintf(stderr, "ERROR: kept frame off by %e, bound %e\n", err, config.compress);
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    // nothing to keep while going backwards
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].store = NULL;
+      data[t_id].hooks = 0;
+    }
+  }
+
+  if( movie ) {
+    movie_wait( movie );
+
+    if(config.verbose) {
+      double stall = 0.0;
+      for( t_id = 0; t_id < config.threads; t_id++ )
+        if( movie->stall[ t_id ] > stall )
+          stall = movie->stall[ t_id ];
+      printf("(ID=0Z): MOVIE  = %u frames, %.2f MB%s -> %s (stalled %.2f ms)\n",
+             movie->frames, movie->written / 1048576.0, movie->direct ? " (direct)" : "", config.mfile, stall );
+    }
+
+    // nothing to write while going backwards
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].movie = NULL;
+      data[t_id].hooks = 0;
+    }
+  }
+
+  if( ckpt ) {
+    checkpoint_wait( ckpt );
+
+    if(config.verbose) {
+      double stall = 0.0;
+      for( t_id = 0; t_id < config.threads; t_id++ )
+        if( ckpt->stall[ t_id ] > stall )
+          stall = ckpt->stall[ t_id ];
+      printf("(ID=0Z): CKPT   = %u saved, %.2f MB -> %s (stalled %.2f ms)\n",
+             ckpt->saved, ckpt->written / 1048576.0, config.cfile, stall );
+    }
+
+    // no checkpoints while going backwards
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].ckpt = NULL;
+      data[t_id].hooks = 0;
+    }
+  }
+
+  if( shm ) {
+    if(config.verbose)
+      printf("(ID=0Z): SHM    = %u frames -> %s\n", shm->hdr->published, config.shm );
+
+    // the consumers keep the last frames
+    shmring_close( shm );
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].shm = NULL;
+      data[t_id].hooks = 0;
+    }
+  }
+
+  if( recv ) {
+    receiver_write( recv, config.tfile, config.randbound, config.model_x0, SEISMIC_H, SEISMIC_DT, config.pulseX, config.pulseY );
+    if(config.verbose)
+      printf("(ID=0Z): TRACES = %u receivers x %u samples -> %s\n", recv->count, recv->samples, config.tfile );
+
+    // nothing to record while going backwards
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      data[t_id].recv = NULL;
+      data[t_id].hooks = 0;
+    }
+  }
+
+  if( config.reverse ) {
+    if(config.verbose)
+      printf("reconstructing source wavefield...\n");
+
+    float * rpulsevector = (float*) malloc( config.timesteps * sizeof(float) );
+    if( rpulsevector == NULL ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+    init_seismic_pulsevector_reversed( rpulsevector, pulsevector, config.timesteps );
+
+    // same kernels, but the last two frames switched: time runs backwards
+    for( t_id = 0; t_id < config.threads; t_id++ ) {
+      float * tmp = data[t_id].apf;
+      data[t_id].apf = data[t_id].nppf;
+      data[t_id].nppf = tmp;
+      data[t_id].pulsevector = rpulsevector;
+      data[t_id].timesteps = config.timesteps - 1;
+      data[t_id].step = 0;
+      // the whole matrix is active already
+      data[t_id].x_start = data[t_id].strip_x_start;
+      data[t_id].x_end = data[t_id].strip_x_end;
+      data[t_id].reach = 0;
+    }
+
+    seismic_run( &config, data, func );
+
+    // last backward step, see init_seismic_pulsevector_reversed()
+    unsigned long pulse = (unsigned long)config.pulseX * config.height + config.pulseY;
+    data[0].apf[ pulse ] += pulsevector[ 2 ];
+
+    // the first frame only contained the very first pulse
+    float err = 0.0f;
+    unsigned long i;
+    for( i = 0; i < (unsigned long)config.width * config.height; i++ ) {
+      float e = fabsf( data[0].apf[ i ] - (i == pulse ? pulsevector[ 0 ] : 0.0f) );
+      if( e > err || e != e )
+        err = e;
+    }
+
+    if(config.verbose) {
+      double elapsedTimeRecon = (data[0].e.tv_sec - data[0].s.tv_sec) * 1000.0 + (data[0].e.tv_usec - data[0].s.tv_usec) / 1000.0; // ms
+      printf("\n");
+      printf("(ID=0Z): RECON  = %.2f ms (GFLOPS: %.2f)\n", elapsedTimeRecon, config.GFLOP * (config.timesteps - 1) / config.timesteps / elapsedTimeRecon );
+      printf("(ID=0Z): ERROR  = %e (pulse: %e)\n", err, fabsf( pulsevector[ 0 ] ) );
+    }
+    else
+      printf("\n");
+    if( ! (err <= config.reverse_error * fabsf( pulsevector[ 0 ] )) ) {
+      fprintf(stderr, "ERROR: reconstruction off by %e, more than %g of the pulse (%e)\n",
+              err, config.reverse_error, fabsf( pulsevector[ 0 ] ));
+      exit(EXIT_FAILURE);
+    }
+
+    // write_matrice() and show_ascii() pick the frame by the parity of timesteps
+    APF = data[0].apf;
+    NPPF = data[0].nppf;
+    if( config.timesteps & 0x1 ) {
+      APF = data[0].nppf;
+      NPPF = data[0].apf;
+    }
+
+    free( rpulsevector );
+  }
+
+  // all time loops, forward and backward
+  if( perf ) {
+    perf_report( perf );
+    perf_destroy( perf );
+  }
+  if( prof ) {
+    prof_report( prof );
+    prof_destroy( prof );
+  }
+
+  // diverged e.g. by velocities beyond the courant value, otherwise the
+  // energy left after the shot passed shows what the boundary reflects
+  {
+    const float * last = config.timesteps & 0x1 ? NPPF : APF;
+    unsigned long i, n = (unsigned long)config.width * config.depth * config.height;
+    double energy = 0.0;
+    float peak = 0.0f;
+    for( i = 0; i < n && isfinite( last[ i ] ); i++ ) {
+      energy += (double)last[ i ] * last[ i ];
+      if( fabsf( last[ i ] ) > peak )
+        peak = fabsf( last[ i ] );
+    }
+    if( i < n )
+      fprintf(stderr, "WARNING: the wavefield diverged, not finite at column %lu row %lu\n", i / config.height, i % config.height);
+    else if(config.verbose)
+      printf("(ID=0Z): ENERGY = %e (max. amplitude: %e)\n", energy, peak );
+  }
+
   if( config.ascii ) {
     show_ascii( &config, config.ascii, APF, NPPF );
   }
-  if( config.output ) {
+  TRACE_START( 0 );
+  if( config.output && snapfile_is( config.ofile ) ) {
+    // the grid as is, incl. random boundary, indexed by chunks
+    snapfile_header_t snap;
+    snapfile_init( &snap, config.width, config.height, 1, config.timesteps, config.variant->name, SEISMIC_DT, SEISMIC_H );
+    snap.randbound = config.randbound;
+    snap.model_x0 = config.model_x0;
+    if( snapfile_write( config.ofile, &snap, config.timesteps & 0x1 ? NPPF : APF ) ) {
+      fprintf(stderr, "ERROR: could not write '%s'\n", config.ofile);
+      exit(EXIT_FAILURE);
+    }
+  }
+  else if( config.output ) {
+    struct timeval o1, o2;
+    gettimeofday(&o1, NULL);
     write_matrice( &config, APF, NPPF );
+    gettimeofday(&o2, NULL);
+    if(config.verbose)
+      printf("(ID=0Z): OUTPUT = %.2f ms%s -> %s\n", (o2.tv_sec - o1.tv_sec) * 1000.0 + (o2.tv_usec - o1.tv_usec) / 1000.0,
+             config.mapped ? " (mapped)" : "", config.ofile );
+  }
+  if( config.output )
+    TRACE_MARK( 0, TRACE_WRITE, config.timesteps );
+
+  if( ooc )
+    ooc_destroy( ooc );
+  else if( config.mapped ) {
+    unmap_matrices();
+    free( VEL );
+  }
+  else {
+    // aligned version!
+    unsigned alignment = config.variant->alignment ? (config.variant->alignment - 2 * sizeof(float)) : 0;
+    free( ((char*)APF) - alignment );
+    free( ((char*)NPPF) - alignment );
+    free( ((char*)VEL) - alignment );
   }
 
-  // aligned version!
-  unsigned alignment = config.variant->alignment ? (config.variant->alignment - 2 * sizeof(float)) : 0;
-  free( ((char*)APF) - alignment );
-  free( ((char*)NPPF) - alignment );
-  free( ((char*)VEL) - alignment );
+  if( store )
+    snapshot_store_destroy( store );
+  if( movie )
+    movie_destroy( movie );
+  if( ckpt )
+    checkpoint_destroy( ckpt );
+
+  // the writers are done
+  if( seismic_trace ) {
+    if( trace_write( seismic_trace, config.timeline ) ) {
+      fprintf(stderr, "ERROR: could not write '%s'\n", config.timeline);
+      exit(EXIT_FAILURE);
+    }
+    if(config.verbose)
+      printf("(ID=0Z): TRACE  = -> %s\n", config.timeline );
+    trace_destroy( seismic_trace );
+    seismic_trace = NULL;
+  }
+  if( recv )
+    receiver_destroy( recv );
+  if( inj )
+    inject_destroy( inj );
+  if( pml )
+    cpml_destroy( pml );
 
   free( pulsevector );
+  free( spulsevector );
   free( data );
-  free( threads );
 
   return 0;
 }
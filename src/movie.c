@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/time.h>
+#include "movie.h"
+#include "trace.h"
+
+// O_DIRECT needs buffers, sizes and offsets aligned to the logical block size
+#define MOVIE_ALIGN       4096
+
+static void * movie_writer( void * v ) {
+  movie_t * movie = (movie_t*) v;
+  struct timespec nap = { 0, 50000 };
+  unsigned f, tr = TRACE_THREAD( "movie writer" );
+
+  for( f = 0; f < movie->frames; f++ ) {
+    unsigned s = f % MOVIE_SLOTS;
+    while( __atomic_load_n( &movie->filled[ s ], __ATOMIC_ACQUIRE ) != movie->threads )
+      nanosleep( &nap, NULL );
+    TRACE_START( tr );
+
+    unsigned long len = movie->frame_bytes;
+    off_t off = movie->data + (off_t)f * movie->frame_bytes;
+    char * p = (char*) movie->buf[ s ];
+    while( len ) {
+      ssize_t n = pwrite( movie->fd, p, len, off );
+      if( n <= 0 ) {
+        fprintf(stderr, "ERROR: could not write frame %u of the movie\n", f);
+        exit(EXIT_FAILURE);
+      }
+      p += n;
+      off += n;
+      len -= n;
+    }
+    movie->written += movie->frame_bytes;
+    TRACE_MARK( tr, TRACE_WRITE, f );
+
+    // hand the slot back, for frame f + MOVIE_SLOTS
+    __atomic_store_n( &movie->filled[ s ], 0, __ATOMIC_RELAXED );
+    __atomic_store_n( &movie->next[ s ], f + MOVIE_SLOTS, __ATOMIC_RELEASE );
+  }
+  return NULL;
+}
+
+// hdr: container, NULL: raw frames
+movie_t * movie_create( const char * file, unsigned width, unsigned height, unsigned frames, unsigned threads, const snapfile_header_t * hdr ) {
+  movie_t * movie = (movie_t*) calloc( 1, sizeof(movie_t) );
+  if( movie == NULL )
+    return NULL;
+
+  movie->width = width;
+  movie->height = height;
+  movie->frames = frames;
+  movie->threads = threads;
+  movie->chunk_cols = hdr ? hdr->chunk_cols : width;
+  movie->chunk_stride = hdr ? snapfile_chunk_stride( hdr ) : (unsigned long)width * height * sizeof(float);
+  movie->frame_bytes = (hdr ? hdr->chunks : 1) * movie->chunk_stride;
+  movie->data = hdr ? hdr->data : 0;
+
+  // bypass the page cache, if every frame starts and ends on a block
+  movie->direct = ! (movie->frame_bytes % MOVIE_ALIGN) && ! (movie->data % MOVIE_ALIGN);
+  movie->fd = -1;
+  if( movie->direct )
+    movie->fd = open( file, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644 );
+  if( movie->fd < 0 ) { // e.g. not supported by the file system
+    movie->direct = 0;
+    movie->fd = open( file, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  }
+  if( movie->fd < 0 ) {
+    fprintf(stderr, "ERROR: could not create movie '%s'\n", file);
+    free( movie );
+    return NULL;
+  }
+
+  if( hdr && snapfile_write_header( movie->fd, hdr ) ) {
+    fprintf(stderr, "ERROR: could not write the header of '%s'\n", file);
+    movie_destroy( movie );
+    return NULL;
+  }
+
+  unsigned i;
+  for( i = 0; i < MOVIE_SLOTS; i++ ) {
+    void * h;
+    if( posix_memalign( &h, MOVIE_ALIGN, movie->frame_bytes ) ) {
+      movie_destroy( movie );
+      return NULL;
+    }
+    memset( h, 0, movie->frame_bytes ); // padding of the chunks
+    movie->buf[ i ] = (float*) h;
+    movie->next[ i ] = i;
+  }
+
+  movie->stall = (double*) calloc( threads, sizeof(double) );
+  if( movie->stall == NULL ) {
+    movie_destroy( movie );
+    return NULL;
+  }
+
+  if( pthread_create( &movie->writer, NULL, movie_writer, movie ) ) {
+    printf("ERROR: Couldn't create the movie writer thread!!\nExiting...\n");
+    exit( EXIT_FAILURE );
+  }
+  return movie;
+}
+
+void movie_put( movie_t * movie, unsigned frame, unsigned id, unsigned x_start, unsigned x_end, const float * frame_src ) {
+  if( frame >= movie->frames )
+    return;
+
+  // only waits, if the writer still holds frame - MOVIE_SLOTS in this slot
+  unsigned s = frame % MOVIE_SLOTS;
+  if( __atomic_load_n( &movie->next[ s ], __ATOMIC_ACQUIRE ) != frame ) {
+    struct timeval w1, w2;
+    gettimeofday(&w1, NULL);
+    while( __atomic_load_n( &movie->next[ s ], __ATOMIC_ACQUIRE ) != frame )
+      sched_yield();
+    gettimeofday(&w2, NULL);
+    movie->stall[ id ] += (w2.tv_sec - w1.tv_sec) * 1000.0 + (w2.tv_usec - w1.tv_usec) / 1000.0;
+  }
+
+  // the strip may span several chunks
+  unsigned long col = (unsigned long)movie->height * sizeof(float);
+  unsigned x = x_start;
+  while( x < x_end ) {
+    unsigned c = x / movie->chunk_cols;
+    unsigned end = (c + 1) * movie->chunk_cols < x_end ? (c + 1) * movie->chunk_cols : x_end;
+    memcpy( (char*) movie->buf[ s ] + c * movie->chunk_stride + (x - c * movie->chunk_cols) * col,
+            &frame_src[ (unsigned long)x * movie->height ], (end - x) * col );
+    x = end;
+  }
+
+  // the last strip completes the frame
+  __atomic_add_fetch( &movie->filled[ s ], 1, __ATOMIC_RELEASE );
+}
+
+void movie_wait( movie_t * movie ) {
+  if( pthread_join( movie->writer, NULL ) ) {
+    printf("ERROR: Couldn't join the movie writer thread!!\nExiting...\n");
+    exit( EXIT_FAILURE );
+  }
+}
+
+void movie_destroy( movie_t * movie ) {
+  unsigned i;
+  for( i = 0; i < MOVIE_SLOTS; i++ )
+    free( movie->buf[ i ] );
+  free( movie->stall );
+  if( movie->fd >= 0 )
+    close( movie->fd );
+  free( movie );
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _MOVIE_H_
+#define _MOVIE_H_
+
+#include <pthread.h>
+#include "snapfile.h"
+
+/*
+  Wavefield movie: every 'every'-th frame of the whole grid (incl. random
+  boundary) is appended to a raw float32 file, width columns of height
+  values per frame, or stored in the chunks of a snapshot container
+  (*.snap, see snapfile.h).
+
+  The frames pass through a ring of MOVIE_SLOTS frame buffers, a lock-free
+  single-producer single-consumer queue ordered by the frame number: the
+  compute threads copy their own strip into the slot of the frame and the
+  one completing it hands the slot over; a writer thread writes the frames
+  in order, each with a single pwrite (O_DIRECT, if the frame size allows),
+  and hands the slot back for frame + MOVIE_SLOTS. A compute thread only
+  waits if the writer is MOVIE_SLOTS frames behind.
+*/
+
+#define MOVIE_SLOTS       2
+
+typedef struct _movie_t movie_t;
+struct _movie_t {
+  int fd;
+  unsigned direct; // opened with O_DIRECT
+  unsigned width;
+  unsigned height;
+  unsigned frames;
+  unsigned threads; // strips per frame
+  unsigned long frame_bytes; // in the file, incl. padding of the chunks
+  unsigned long data; // offset of frame 0
+  unsigned chunk_cols; // raw: a single chunk of width columns
+  unsigned long chunk_stride;
+
+  float * buf[ MOVIE_SLOTS ];
+  unsigned filled[ MOVIE_SLOTS ]; // strips copied, atomic
+  unsigned next[ MOVIE_SLOTS ]; // frame the slot takes next, atomic
+
+  pthread_t writer;
+  unsigned long written; // bytes, statistics
+  double * stall; // ms, per compute thread
+};
+
+movie_t * movie_create( const char * file, unsigned width, unsigned height, unsigned frames, unsigned threads, const snapfile_header_t * hdr );
+void movie_put( movie_t * movie, unsigned frame, unsigned id, unsigned x_start, unsigned x_end, const float * frame_src );
+void movie_wait( movie_t * movie );
+void movie_destroy( movie_t * movie );
+
+#endif /* #ifndef _MOVIE_H_ */
@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include "outofcore.h"
+#include "trace.h"
+
+// slot buffers: [2] is aligned to this, like the in-memory matrices
+#define OOC_ALIGN         64
+
+static int ooc_open( const char * dir, const char * name, unsigned long len ) {
+  char path[4096];
+  snprintf( path, sizeof(path), "%s/%s", dir, name );
+
+  // sparse, hence all zero without writing anything
+  int fd = open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if( fd < 0 || ftruncate( fd, len ) ) {
+    fprintf(stderr, "ERROR: could not create '%s'\n", path);
+    if( fd >= 0 )
+      close( fd );
+    return -1;
+  }
+  return fd;
+}
+
+static float * ooc_map( int fd, unsigned long len, int prot ) {
+  void * map = mmap( NULL, len, prot, MAP_SHARED, fd, 0 );
+  return map == MAP_FAILED ? NULL : (float*) map;
+}
+
+static float * ooc_alloc( unsigned long floats ) {
+  void * h;
+  if( posix_memalign( &h, OOC_ALIGN, floats * sizeof(float) + OOC_ALIGN ) )
+    return NULL;
+  return (float*)((char*)h + OOC_ALIGN - 2 * sizeof(float));
+}
+
+static void ooc_free( float * buf ) {
+  if( buf )
+    free( (char*)buf - (OOC_ALIGN - 2 * sizeof(float)) );
+}
+
+// columns [x_start, x_end) from / to the file
+static void ooc_io( ooc_t * ooc, int fd, float * buf, unsigned x_start, unsigned x_end, int write ) {
+  unsigned long len = (unsigned long)(x_end - x_start) * ooc->height * sizeof(float);
+  off_t off = (off_t)x_start * ooc->height * sizeof(float);
+  char * p = (char*) buf;
+
+  while( len ) {
+    ssize_t n = write ? pwrite( fd, p, len, off ) : pread( fd, p, len, off );
+    if( n <= 0 ) {
+      fprintf(stderr, "ERROR: out-of-core %s failed\n", write ? "write" : "read");
+      exit(EXIT_FAILURE);
+    }
+    p += n;
+    off += n;
+    len -= n;
+  }
+}
+
+// own columns [b0, b1) of a task, loaded with the halo [lo, hi)
+static unsigned ooc_block( ooc_t * ooc, unsigned task, unsigned * lo, unsigned * hi, unsigned * b0, unsigned * b1 ) {
+  unsigned pass = task / ooc->blocks, block = task % ooc->blocks;
+  unsigned steps = ooc->timesteps - pass * ooc->steps;
+  if( steps > ooc->steps )
+    steps = ooc->steps;
+
+  unsigned halo = 2 * steps;
+  *b0 = block * ooc->cols;
+  *b1 = *b0 + ooc->cols < ooc->width ? *b0 + ooc->cols : ooc->width;
+  *lo = *b0 > halo ? *b0 - halo : 0;
+  *hi = *b1 + halo < ooc->width ? *b1 + halo : ooc->width;
+  return steps;
+}
+
+static void ooc_load( ooc_t * ooc, ooc_slot_t * s, unsigned task ) {
+  unsigned lo, hi, b0, b1, gen = (task / ooc->blocks) & 0x1;
+  ooc_block( ooc, task, &lo, &hi, &b0, &b1 );
+
+  TRACE_START( ooc->trace );
+  ooc_io( ooc, ooc->fd_apf[ gen ], s->buf[0], lo, hi, 0 );
+  ooc_io( ooc, ooc->fd_nppf[ gen ], s->buf[1], lo, hi, 0 );
+  ooc_io( ooc, ooc->fd_vel, s->buf[2], lo, hi, 0 );
+  ooc->read += (unsigned long)(hi - lo) * ooc->height * sizeof(float) * 3;
+  TRACE_MARK( ooc->trace, TRACE_READ, task );
+
+  pthread_mutex_lock( &ooc->lock );
+  s->task = task;
+  s->state = OOC_LOADED;
+  pthread_cond_broadcast( &ooc->cond );
+  pthread_mutex_unlock( &ooc->lock );
+}
+
+// waits for the computation of the slot, writes its own columns into the next generation
+static void ooc_flush( ooc_t * ooc, ooc_slot_t * s ) {
+  pthread_mutex_lock( &ooc->lock );
+  while( s->state == OOC_LOADED )
+    pthread_cond_wait( &ooc->cond, &ooc->lock );
+  unsigned state = s->state;
+  pthread_mutex_unlock( &ooc->lock );
+
+  if( state != OOC_DONE )
+    return;
+
+  unsigned lo, hi, b0, b1, gen = ((s->task / ooc->blocks) + 1) & 0x1;
+  ooc_block( ooc, s->task, &lo, &hi, &b0, &b1 );
+
+  unsigned long skip = (unsigned long)(b0 - lo) * ooc->height;
+  TRACE_START( ooc->trace );
+  ooc_io( ooc, ooc->fd_apf[ gen ], &s->cur[ skip ], b0, b1, 1 );
+  ooc_io( ooc, ooc->fd_nppf[ gen ], &s->prev[ skip ], b0, b1, 1 );
+  ooc->written += (unsigned long)(b1 - b0) * ooc->height * sizeof(float) * 2;
+  TRACE_MARK( ooc->trace, TRACE_WRITE, s->task );
+
+  pthread_mutex_lock( &ooc->lock );
+  s->state = OOC_FREE;
+  pthread_cond_broadcast( &ooc->cond );
+  pthread_mutex_unlock( &ooc->lock );
+}
+
+static void * ooc_worker( void * v ) {
+  ooc_t * ooc = (ooc_t*) v;
+  unsigned tasks = ooc->passes * ooc->blocks, i;
+  ooc->trace = TRACE_THREAD( "out-of-core I/O" );
+
+  for( i = 0; i < tasks; i++ ) {
+    // a new pass reads what the previous one wrote, all of it
+    if( i && ! (i % ooc->blocks) )
+      ooc_flush( ooc, &ooc->slot[ (i - 1) & 0x1 ] );
+    ooc_flush( ooc, &ooc->slot[ i & 0x1 ] );
+    ooc_load( ooc, &ooc->slot[ i & 0x1 ], i );
+  }
+  ooc_flush( ooc, &ooc->slot[ tasks & 0x1 ] );
+  ooc_flush( ooc, &ooc->slot[ (tasks + 1) & 0x1 ] );
+  return NULL;
+}
+
+ooc_t * ooc_create( const char * dir, unsigned width, unsigned height, unsigned timesteps, unsigned cols, unsigned steps ) {
+  ooc_t * ooc = (ooc_t*) calloc( 1, sizeof(ooc_t) );
+  if( ooc == NULL )
+    return NULL;
+
+  ooc->width = width;
+  ooc->height = height;
+  ooc->cols = cols;
+  ooc->steps = steps;
+  ooc->blocks = (width + cols - 1) / cols;
+  ooc->passes = (timesteps + steps - 1) / steps;
+  ooc->timesteps = timesteps;
+  ooc->len = (unsigned long)width * height * sizeof(float);
+
+  ooc->fd_vel = ooc_open( dir, "vel", ooc->len );
+  ooc->fd_apf[0] = ooc_open( dir, "apf.0", ooc->len );
+  ooc->fd_nppf[0] = ooc_open( dir, "nppf.0", ooc->len );
+  ooc->fd_apf[1] = ooc_open( dir, "apf.1", ooc->len );
+  ooc->fd_nppf[1] = ooc_open( dir, "nppf.1", ooc->len );
+  if( ooc->fd_vel < 0 || ooc->fd_apf[0] < 0 || ooc->fd_nppf[0] < 0 || ooc->fd_apf[1] < 0 || ooc->fd_nppf[1] < 0 )
+    exit(EXIT_FAILURE);
+
+  ooc->apf = ooc_map( ooc->fd_apf[0], ooc->len, PROT_READ | PROT_WRITE );
+  ooc->nppf = ooc_map( ooc->fd_nppf[0], ooc->len, PROT_READ | PROT_WRITE );
+  ooc->vel = ooc_map( ooc->fd_vel, ooc->len, PROT_READ | PROT_WRITE );
+
+  // the largest block: own columns and both halos
+  unsigned slot_cols = cols + 4 * steps < width ? cols + 4 * steps : width;
+  ooc->slot_floats = (unsigned long)slot_cols * height;
+  unsigned i, j;
+  for( i = 0; i < 2; i++ ) {
+    for( j = 0; j < 3; j++ )
+      ooc->slot[i].buf[j] = ooc_alloc( ooc->slot_floats );
+    ooc->slot[i].state = OOC_FREE;
+  }
+
+  pthread_mutex_init( &ooc->lock, NULL );
+  pthread_cond_init( &ooc->cond, NULL );
+
+  ooc->pulse.count = 1;
+  ooc->pulse.offset = &ooc->pulse_offset;
+  ooc->pulse.x = &ooc->pulse_x;
+  ooc->pulse.steps = timesteps + 1;
+
+  for( i = 0; i < 2; i++ )
+    for( j = 0; j < 3; j++ )
+      if( ooc->slot[i].buf[j] == NULL ) {
+        ooc_destroy( ooc );
+        return NULL;
+      }
+  if( ooc->apf == NULL || ooc->nppf == NULL || ooc->vel == NULL ) {
+    ooc_destroy( ooc );
+    return NULL;
+  }
+  return ooc;
+}
+
+void ooc_run( ooc_t * ooc, config_t * config, stack_t * data ) {
+  struct timeval s, e, w1, w2;
+  gettimeofday(&s, NULL);
+
+  // the drivers insert the first pulse, here it has to be in the file
+  ooc->apf[ (unsigned long)config->pulseX * ooc->height + config->pulseY ] += data[0].pulsevector[0];
+  ooc->pulse.amp = data[0].pulsevector;
+
+  munmap( ooc->apf, ooc->len );
+  munmap( ooc->nppf, ooc->len );
+  munmap( ooc->vel, ooc->len );
+  ooc->apf = ooc->nppf = ooc->vel = NULL;
+
+  pthread_t io;
+  if( pthread_create( &io, NULL, ooc_worker, ooc ) ) {
+    printf("ERROR: Couldn't create the out-of-core I/O thread!!\nExiting...\n");
+    exit( EXIT_FAILURE );
+  }
+
+  unsigned tasks = ooc->passes * ooc->blocks, i, t_id;
+  for( i = 0; i < tasks; i++ ) {
+    ooc_slot_t * slot = &ooc->slot[ i & 0x1 ];
+
+    gettimeofday(&w1, NULL);
+    pthread_mutex_lock( &ooc->lock );
+    while( slot->state != OOC_LOADED || slot->task != i )
+      pthread_cond_wait( &ooc->cond, &ooc->lock );
+    pthread_mutex_unlock( &ooc->lock );
+    gettimeofday(&w2, NULL);
+    ooc->wait += (w2.tv_sec - w1.tv_sec) * 1000.0 + (w2.tv_usec - w1.tv_usec) / 1000.0;
+
+    unsigned lo, hi, b0, b1;
+    unsigned steps = ooc_block( ooc, i, &lo, &hi, &b0, &b1 );
+    unsigned width = hi - lo, part = (width - 4) / config->threads;
+
+    // the pulse is added by the hooks, the drivers only know it at step 0
+    unsigned pulse = lo <= config->pulseX && config->pulseX < hi;
+    ooc->pulse_x = config->pulseX - lo;
+    ooc->pulse_offset = (unsigned long)ooc->pulse_x * ooc->height + config->pulseY;
+
+    for( t_id = 0; t_id < config->threads; t_id++ ) {
+      data[t_id].apf = slot->buf[0];
+      data[t_id].nppf = slot->buf[1];
+      data[t_id].vel = slot->buf[2];
+      data[t_id].width = width;
+      data[t_id].timesteps = steps;
+      data[t_id].step = (i / ooc->blocks) * ooc->steps;
+      data[t_id].set_pulse = 0;
+
+      data[t_id].x_start = 2 + t_id * part;
+      data[t_id].x_end = t_id + 1 == config->threads ? width - 2 : data[t_id].x_start + part;
+      data[t_id].strip_x_start = data[t_id].x_start;
+      data[t_id].strip_x_end = data[t_id].x_end;
+      data[t_id].reach = 0;
+
+      data[t_id].inj = pulse ? &ooc->pulse : NULL;
+      data[t_id].i_start = data[t_id].i_end = 0;
+      if( pulse )
+        inject_range( &ooc->pulse, STRIP_X_START( &data[t_id] ), STRIP_X_END( &data[t_id] ),
+                      &data[t_id].i_start, &data[t_id].i_end );
+      data[t_id].hooks = pulse;
+    }
+
+    seismic_run( config, data, config->variant->fnc_par );
+
+    pthread_mutex_lock( &ooc->lock );
+    slot->cur = data[0].apf;
+    slot->prev = data[0].nppf;
+    slot->state = OOC_DONE;
+    pthread_cond_broadcast( &ooc->cond );
+    pthread_mutex_unlock( &ooc->lock );
+
+    // shows one # at each 10% of the passes
+    unsigned pass = i / ooc->blocks;
+    if( i % ooc->blocks == ooc->blocks - 1 && (pass + 1) * 10 / ooc->passes != pass * 10 / ooc->passes ) {
+      printf("#");
+      fflush(stdout);
+    }
+  }
+
+  if( pthread_join( io, NULL ) ) {
+    printf("ERROR: Couldn't join the out-of-core I/O thread!!\nExiting...\n");
+    exit( EXIT_FAILURE );
+  }
+
+  gettimeofday(&e, NULL);
+  data[0].s = s;
+  data[0].e = e;
+
+  // newest frame and the one before
+  unsigned gen = ooc->passes & 0x1;
+  ooc->apf = ooc_map( ooc->fd_apf[ gen ], ooc->len, PROT_READ );
+  ooc->nppf = ooc_map( ooc->fd_nppf[ gen ], ooc->len, PROT_READ );
+  if( ooc->apf == NULL || ooc->nppf == NULL ) {
+    fprintf(stderr, "ERROR: could not map the out-of-core result\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void ooc_destroy( ooc_t * ooc ) {
+  unsigned i, j;
+  if( ooc->apf )
+    munmap( ooc->apf, ooc->len );
+  if( ooc->nppf )
+    munmap( ooc->nppf, ooc->len );
+  if( ooc->vel )
+    munmap( ooc->vel, ooc->len );
+
+  close( ooc->fd_vel );
+  for( i = 0; i < 2; i++ ) {
+    close( ooc->fd_apf[i] );
+    close( ooc->fd_nppf[i] );
+    for( j = 0; j < 3; j++ )
+      ooc_free( ooc->slot[i].buf[j] );
+  }
+
+  pthread_mutex_destroy( &ooc->lock );
+  pthread_cond_destroy( &ooc->cond );
+  free( ooc );
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _OUTOFCORE_H_
+#define _OUTOFCORE_H_
+
+#include <pthread.h>
+#include "config.h"
+#include "kernel.h"
+#include "inject.h"
+
+/*
+  Out-of-core propagation for models larger than the memory. APF, NPPF and
+  VEL live in files of a directory, two generations of APF / NPPF:
+
+    vel, apf.0, nppf.0, apf.1, nppf.1
+
+  The run is split into passes of 'steps' timesteps. Each pass streams the
+  columns along x in blocks of 'cols' columns, every block is loaded with a
+  halo of 2 * steps columns per side, advanced by 'steps' timesteps at once
+  (the halo shrinks by 2 columns per timestep) and only its own columns are
+  written into the other generation. A pass therefore reads every value
+  once (plus the halos) for 'steps' timesteps.
+
+  An I/O thread loads the next block and writes back the previous one while
+  the compute threads work on the current one, two slots in turn.
+  Before the run, the files of generation 0 are mapped (ooc->apf, nppf,
+  vel) for the initialisation, afterwards the final frames (read-only).
+*/
+
+enum { OOC_FREE, OOC_LOADED, OOC_DONE };
+
+typedef struct _ooc_slot_t ooc_slot_t;
+struct _ooc_slot_t {
+  float * buf[3]; // apf, nppf, vel of the block incl. halo
+  float * cur; // after the block: newest and previous frame
+  float * prev;
+  unsigned task; // pass * blocks + block
+  unsigned state; // OOC_FREE, OOC_LOADED, OOC_DONE
+};
+
+typedef struct _ooc_t ooc_t;
+struct _ooc_t {
+  unsigned width;
+  unsigned height;
+  unsigned cols; // per block
+  unsigned steps; // per pass
+  unsigned blocks;
+  unsigned passes;
+  unsigned timesteps;
+
+  int fd_vel;
+  int fd_apf[2]; // generations
+  int fd_nppf[2];
+
+  float * apf; // mapped, see above
+  float * nppf;
+  float * vel;
+  unsigned long len; // bytes per file
+
+  ooc_slot_t slot[2];
+  unsigned long slot_floats;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond; // slot loaded / done / written
+
+  inject_t pulse; // the pulse within the current block
+  unsigned long pulse_offset;
+  unsigned pulse_x;
+
+  unsigned long read; // bytes, statistics
+  unsigned long written;
+  double wait; // ms the compute threads waited for I/O
+  unsigned trace; // track of the I/O thread, see trace.h
+};
+
+ooc_t * ooc_create( const char * dir, unsigned width, unsigned height, unsigned timesteps, unsigned cols, unsigned steps );
+void ooc_run( ooc_t * ooc, config_t * config, stack_t * data );
+void ooc_destroy( ooc_t * ooc );
+
+void seismic_run( config_t * config, stack_t * data, void (* func)(void *) ); // main.c
+
+#endif /* #ifndef _OUTOFCORE_H_ */
@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "kernel.h"
+#include "perf.h"
+
+#define UNCORE_DIR    "/sys/bus/event_source/devices"
+
+static const char * perf_names[ PERF_EVENTS ] = { "task-clock", "cycles", "instructions", "L1D misses", "LLC misses" };
+
+static int perf_open( uint32_t type, uint64_t config, int pid, int cpu, unsigned user ) {
+  struct perf_event_attr attr;
+  memset( &attr, 0, sizeof(attr) );
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = user; // allowed with perf_event_paranoid 2
+  attr.exclude_hv = user;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall( SYS_perf_event_open, &attr, pid, cpu, -1, 0 );
+}
+
+// scaled up, if the counter had to share the PMU
+static uint64_t perf_read( int fd ) {
+  uint64_t v[ 3 ];
+  if( read( fd, v, sizeof(v) ) != sizeof(v) )
+    return PERF_NA;
+  return v[ 2 ] && v[ 2 ] < v[ 1 ] ? (uint64_t)((double)v[ 0 ] * v[ 1 ] / v[ 2 ]) : v[ 0 ];
+}
+
+static int perf_sysfs( const char * file, char * buf, unsigned len ) {
+  FILE * f = fopen( file, "r" );
+  if( f == NULL )
+    return -1;
+  int ok = fgets( buf, len, f ) != NULL;
+  fclose( f );
+  buf[ strcspn( buf, "\n" ) ] = '\0';
+  return ok ? 0 : -1;
+}
+
+// "event=0x04,umask=0x03" into config, by the format/ of the PMU
+static int perf_uncore_config( const char * pmu, const char * spec, uint64_t * config ) {
+  char buf[ 256 ], file[ 512 ];
+  strncpy( buf, spec, sizeof(buf) - 1 );
+  buf[ sizeof(buf) - 1 ] = '\0';
+
+  *config = 0;
+  char * save = NULL, * term;
+  for( term = strtok_r( buf, ",", &save ); term != NULL; term = strtok_r( NULL, ",", &save ) ) {
+    char * eq = strchr( term, '=' );
+    if( eq == NULL )
+      return -1;
+    *eq = '\0';
+
+    char fmt[ 64 ];
+    unsigned lo;
+    snprintf( file, sizeof(file), "%s/%s/format/%s", UNCORE_DIR, pmu, term );
+    if( perf_sysfs( file, fmt, sizeof(fmt) ) || sscanf( fmt, "config:%u", &lo ) != 1 )
+      return -1;
+    *config |= strtoull( eq + 1, NULL, 0 ) << lo;
+  }
+  return 0;
+}
+
+// CAS commands of all memory controllers, on the first cpu of each
+static void perf_uncore_open( perf_t * perf ) {
+  DIR * dir = opendir( UNCORE_DIR );
+  if( dir == NULL )
+    return;
+
+  struct dirent * d;
+  while( (d = readdir( dir )) != NULL && perf->uncore_c + 2 <= PERF_UNCORE_MAX ) {
+    if( strncmp( d->d_name, "uncore_imc", 10 ) )
+      continue;
+
+    char file[ 512 ], buf[ 256 ];
+    unsigned type, w;
+    int cpu = 0;
+    snprintf( file, sizeof(file), "%s/%s/type", UNCORE_DIR, d->d_name );
+    if( perf_sysfs( file, buf, sizeof(buf) ) || sscanf( buf, "%u", &type ) != 1 )
+      continue;
+    snprintf( file, sizeof(file), "%s/%s/cpumask", UNCORE_DIR, d->d_name );
+    if( ! perf_sysfs( file, buf, sizeof(buf) ) )
+      cpu = atoi( buf );
+
+    for( w = 0; w < 2; w++ ) {
+      uint64_t config;
+      snprintf( file, sizeof(file), "%s/%s/events/%s", UNCORE_DIR, d->d_name, w ? "cas_count_write" : "cas_count_read" );
+      if( perf_sysfs( file, buf, sizeof(buf) ) || perf_uncore_config( d->d_name, buf, &config ) )
+        continue;
+
+      int fd = perf_open( type, config, -1, cpu, 0 );
+      if( fd < 0 ) {
+        if( ! perf->error )
+          perf->error = errno;
+        continue;
+      }
+      perf->uwrite[ perf->uncore_c ] = w;
+      perf->ufd[ perf->uncore_c++ ] = fd;
+    }
+  }
+  closedir( dir );
+}
+
+perf_t * perf_create( unsigned threads, unsigned uncore ) {
+  perf_t * perf = (perf_t*) calloc( 1, sizeof(perf_t) );
+  if( perf == NULL )
+    return NULL;
+  perf->thread = (perf_thread_t*) calloc( threads, sizeof(perf_thread_t) );
+  if( perf->thread == NULL ) {
+    free( perf );
+    return NULL;
+  }
+  perf->threads = threads;
+  perf->uncore = uncore;
+  return perf;
+}
+
+void perf_begin( stack_t * data ) {
+  static const struct { uint32_t type; uint64_t config; } ev[ PERF_EVENTS ] = {
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }, // LLC
+  };
+  perf_t * perf = data->perf;
+  perf_thread_t * th = &perf->thread[ data->id ];
+
+  // the calling thread only, opened disabled
+  unsigned i;
+  for( i = 0; i < PERF_EVENTS; i++ ) {
+    th->fd[ i ] = perf_open( ev[ i ].type, ev[ i ].config, 0, -1, 1 );
+    if( th->fd[ i ] < 0 && ! perf->error )
+      perf->error = errno;
+  }
+  if( ! data->id && perf->uncore )
+    perf_uncore_open( perf );
+
+  for( i = 0; i < PERF_EVENTS; i++ )
+    if( th->fd[ i ] >= 0 )
+      ioctl( th->fd[ i ], PERF_EVENT_IOC_ENABLE, 0 );
+  for( i = 0; ! data->id && i < perf->uncore_c; i++ )
+    ioctl( perf->ufd[ i ], PERF_EVENT_IOC_ENABLE, 0 );
+}
+
+void perf_end( stack_t * data ) {
+  perf_t * perf = data->perf;
+  perf_thread_t * th = &perf->thread[ data->id ];
+
+  unsigned i;
+  for( i = 0; i < PERF_EVENTS; i++ )
+    if( th->fd[ i ] >= 0 )
+      ioctl( th->fd[ i ], PERF_EVENT_IOC_DISABLE, 0 );
+  for( i = 0; ! data->id && i < perf->uncore_c; i++ )
+    ioctl( perf->ufd[ i ], PERF_EVENT_IOC_DISABLE, 0 );
+
+  // once not available, it stays so
+  for( i = 0; i < PERF_EVENTS; i++ ) {
+    uint64_t v = th->fd[ i ] >= 0 ? perf_read( th->fd[ i ] ) : PERF_NA;
+    th->count[ i ] = v == PERF_NA || th->count[ i ] == PERF_NA ? PERF_NA : th->count[ i ] + v;
+    if( th->fd[ i ] >= 0 )
+      close( th->fd[ i ] );
+  }
+  for( i = 0; ! data->id && i < perf->uncore_c; i++ ) {
+    uint64_t v = perf_read( perf->ufd[ i ] );
+    if( v != PERF_NA )
+      *(perf->uwrite[ i ] ? &perf->uwrite_bytes : &perf->uread_bytes) += (double)v * PERF_LINE;
+    close( perf->ufd[ i ] );
+  }
+  if( ! data->id )
+    perf->uncore_c = 0;
+
+  // the own strip; clopt: interleaved rows of the whole matrix
+  double points = (double)(data->strip_x_end - data->strip_x_start) * (data->y_end - data->y_start) * (data->z_end - data->z_start);
+  if( data->clopt )
+    points = (double)(data->width - 4) * (data->height - 4) / perf->threads;
+  th->points += points * data->timesteps;
+  th->ms += (data->e.tv_sec - data->s.tv_sec) * 1000.0 + (data->e.tv_usec - data->s.tv_usec) / 1000.0;
+}
+
+static void perf_cell( uint64_t v, double div, const char * fmt ) {
+  if( v == PERF_NA )
+    printf(" %10s", "n/a");
+  else
+    printf(fmt, v / div);
+}
+
+void perf_report( perf_t * perf ) {
+  perf_thread_t all;
+  memset( &all, 0, sizeof(all) );
+
+  unsigned t, i;
+  for( t = 0; t < perf->threads; t++ ) {
+    perf_thread_t * th = &perf->thread[ t ];
+    for( i = 0; i < PERF_EVENTS; i++ )
+      all.count[ i ] = th->count[ i ] == PERF_NA || all.count[ i ] == PERF_NA ? PERF_NA : all.count[ i ] + th->count[ i ];
+    all.points += th->points;
+    if( th->ms > all.ms ) // the threads run side by side
+      all.ms = th->ms;
+  }
+
+  printf("(ID=0Z): PERF   = per thread, per grid point and timestep\n");
+  printf("%6s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+         "thread", "cpu ms", "cycles/pt", "instr/pt", "IPC", "L1D m/pt", "LLC m/pt", "B/pt", "GB/s");
+  for( t = 0; t <= perf->threads; t++ ) {
+    perf_thread_t * th = t < perf->threads ? &perf->thread[ t ] : &all;
+    if( t < perf->threads )
+      printf("%6u", t);
+    else
+      printf("%6s", "all");
+    double pt = th->points ? th->points : 1.0;
+    uint64_t llc = th->count[ PERF_LLC_MISSES ];
+    perf_cell( th->count[ PERF_TASK_CLOCK ], 1e6, " %10.2f" );
+    perf_cell( th->count[ PERF_CYCLES ], pt, " %10.2f" );
+    perf_cell( th->count[ PERF_INSTRUCTIONS ], pt, " %10.2f" );
+    if( th->count[ PERF_CYCLES ] == PERF_NA || th->count[ PERF_INSTRUCTIONS ] == PERF_NA || ! th->count[ PERF_CYCLES ] )
+      printf(" %10s", "n/a");
+    else
+      printf(" %10.2f", (double)th->count[ PERF_INSTRUCTIONS ] / th->count[ PERF_CYCLES ]);
+    perf_cell( th->count[ PERF_L1D_MISSES ], pt, " %10.4f" );
+    perf_cell( llc, pt, " %10.4f" );
+    // every LLC miss a line from (or to) memory
+    perf_cell( llc, pt / PERF_LINE, " %10.2f" );
+    perf_cell( llc, (th->ms ? th->ms : 1.0) * 1e6 / PERF_LINE, " %10.2f" );
+    printf("\n");
+  }
+
+  for( i = 0; i < PERF_EVENTS; i++ )
+    if( all.count[ i ] == PERF_NA ) {
+      printf("(ID=0Z): PERF   = %s not available: %s\n", perf_names[ i ],
+             perf->error == EACCES || perf->error == EPERM ? "not permitted, see perf_event_paranoid" : "no such counter (PMU) here");
+      break;
+    }
+
+  if( perf->uncore ) {
+    double ms = perf->thread[ 0 ].ms ? perf->thread[ 0 ].ms : 1.0;
+    if( perf->uread_bytes + perf->uwrite_bytes > 0.0 )
+      printf("(ID=0Z): DRAM   = %.2f MB read, %.2f MB written, %.2f B/pt, %.2f GB/s\n",
+             perf->uread_bytes / 1e6, perf->uwrite_bytes / 1e6,
+             (perf->uread_bytes + perf->uwrite_bytes) / (all.points ? all.points : 1.0),
+             (perf->uread_bytes + perf->uwrite_bytes) / ms / 1e6);
+    else
+      printf("(ID=0Z): DRAM   = not available, no uncore_imc counters\n");
+  }
+}
+
+void perf_destroy( perf_t * perf ) {
+  free( perf->thread );
+  free( perf );
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _PERF_H_
+#define _PERF_H_
+
+#include <stdint.h>
+
+/*
+  Hardware counters of the compute threads (--perf): each thread opens its
+  own perf_event_open counters right before its time loop and reads and
+  closes them right after, see SEISMIC_LOOP_BEGIN / _END. The counts add
+  up over all time loops of a run (e.g. forward and backward of reverse).
+
+  Events the machine or perf_event_paranoid does not allow are left out
+  (PERF_NA), the software task-clock is always there. With 'uncore', thread
+  0 also counts the CAS commands of the memory controllers (uncore_imc_*,
+  system-wide, needs perf_event_paranoid <= 0) for the DRAM traffic.
+*/
+
+enum { PERF_TASK_CLOCK, PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_EVENTS };
+
+#define PERF_NA             UINT64_MAX
+#define PERF_UNCORE_MAX     16 // read and write of 8 memory controllers
+#define PERF_LINE           64 // bytes per cache line / CAS
+
+typedef struct _perf_thread_t perf_thread_t;
+struct _perf_thread_t {
+  int fd[ PERF_EVENTS ];
+  uint64_t count[ PERF_EVENTS ]; // PERF_NA: not available
+  double ms; // within the time loops
+  double points; // grid points updated
+};
+
+typedef struct _perf_t perf_t;
+struct _perf_t {
+  unsigned threads;
+  unsigned uncore; // count the memory controllers too
+  perf_thread_t * thread;
+  int error; // errno of the first counter that failed
+
+  unsigned uncore_c;
+  int ufd[ PERF_UNCORE_MAX ];
+  unsigned uwrite[ PERF_UNCORE_MAX ]; // counts writes, reads otherwise
+  double uread_bytes;
+  double uwrite_bytes;
+};
+
+struct _stack_t;
+
+perf_t * perf_create( unsigned threads, unsigned uncore );
+void perf_begin( struct _stack_t * data );
+void perf_end( struct _stack_t * data );
+void perf_report( perf_t * perf );
+void perf_destroy( perf_t * perf );
+
+#endif /* #ifndef _PERF_H_ */
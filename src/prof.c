@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "prof.h"
+
+#define PROF_BAR      40 // width of the histogram
+
+prof_t * prof_create( unsigned threads, unsigned timesteps ) {
+  prof_t * prof = (prof_t*) calloc( 1, sizeof(prof_t) );
+  if( prof == NULL )
+    return NULL;
+  if( posix_memalign( (void**)&prof->thread, PROF_LINE, threads * sizeof(prof_thread_t) ) ) {
+    free( prof );
+    return NULL;
+  }
+  memset( prof->thread, 0, threads * sizeof(prof_thread_t) );
+  prof->threads = threads;
+  prof->cap = timesteps;
+
+  unsigned t;
+  for( t = 0; t < threads; t++ ) {
+    prof->thread[ t ].c = (uint64_t*) calloc( timesteps ? timesteps : 1, sizeof(uint64_t) );
+    prof->thread[ t ].w = (uint64_t*) calloc( timesteps ? timesteps : 1, sizeof(uint64_t) );
+    if( prof->thread[ t ].c == NULL || prof->thread[ t ].w == NULL ) {
+      prof->threads = t + 1;
+      prof_destroy( prof );
+      return NULL;
+    }
+  }
+  return prof;
+}
+
+void prof_end( prof_t * prof, unsigned id ) {
+  prof_thread_t * th = &prof->thread[ id ];
+  uint64_t now = prof_now();
+  th->compute += now - th->last;
+  th->last = now;
+  if( th->n && th->n <= prof->cap ) {
+    th->c[ th->n - 1 ] += th->compute;
+    th->w[ th->n - 1 ] += th->wait;
+  }
+  th->compute = th->wait = 0;
+}
+
+void prof_report( prof_t * prof ) {
+  unsigned t, s, n = prof->cap;
+  for( t = 0; t < prof->threads; t++ )
+    if( prof->thread[ t ].n < n )
+      n = prof->thread[ t ].n;
+  if( ! n ) {
+    printf("(ID=0Z): IMBAL  = no timesteps recorded\n");
+    return;
+  }
+
+  double * compute = (double*) calloc( prof->threads, sizeof(double) );
+  double * wait = (double*) calloc( prof->threads, sizeof(double) );
+  unsigned * slowest = (unsigned*) calloc( prof->threads, sizeof(unsigned) );
+  if( compute == NULL || wait == NULL || slowest == NULL ) {
+    printf("allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // per timestep, the slowest thread against the average one
+  double sum_max = 0.0, sum_mean = 0.0, worst = 0.0;
+  unsigned worst_step = 0;
+  for( s = 0; s < n; s++ ) {
+    uint64_t max = 0, sum = 0;
+    unsigned arg = 0;
+    for( t = 0; t < prof->threads; t++ ) {
+      prof_thread_t * th = &prof->thread[ t ];
+      compute[ t ] += th->c[ s ];
+      wait[ t ] += th->w[ s ];
+      sum += th->c[ s ];
+      if( th->c[ s ] > max ) {
+        max = th->c[ s ];
+        arg = t;
+      }
+    }
+    slowest[ arg ]++;
+    double mean = (double)sum / prof->threads;
+    sum_max += max;
+    sum_mean += mean;
+    if( mean > 0.0 && max / mean > worst ) {
+      worst = max / mean;
+      worst_step = s;
+    }
+  }
+
+  double total_c = 0.0, total_w = 0.0;
+  printf("(ID=0Z): IMBAL  = %u timesteps%s, compute and barrier wait per thread\n",
+         n, n < prof->thread[ 0 ].n ? " (the first ones)" : "");
+  printf("%6s %12s %12s %8s  %s\n", "thread", "compute ms", "wait ms", "wait %", "slowest in timesteps");
+  for( t = 0; t < prof->threads; t++ ) {
+    double all = compute[ t ] + wait[ t ];
+    unsigned b = (unsigned)((double)slowest[ t ] / n * PROF_BAR + 0.5), i;
+    printf("%6u %12.2f %12.2f %7.2f%%  %6u |", t, compute[ t ] / 1e6, wait[ t ] / 1e6,
+           all > 0.0 ? 100.0 * wait[ t ] / all : 0.0, slowest[ t ]);
+    for( i = 0; i < b; i++ )
+      printf("#");
+    printf("\n");
+    total_c += compute[ t ];
+    total_w += wait[ t ];
+  }
+
+  // waiting beyond the gap to the slowest thread is the barrier itself
+  double imbal = (sum_max - sum_mean) / 1e6;
+  double sync = total_w / prof->threads / 1e6 - imbal;
+  if( sync < 0.0 )
+    sync = 0.0;
+  printf("(ID=0Z): IMBAL  = max / mean compute %.3f (worst %.3f in timestep %u), wait %.2f%% of all thread time\n",
+         sum_mean > 0.0 ? sum_max / sum_mean : 1.0, worst, worst_step,
+         total_c + total_w > 0.0 ? 100.0 * total_w / (total_c + total_w) : 0.0);
+  printf("(ID=0Z): IMBAL  = per thread %.2f ms behind the slowest one (partitioning), %.2f ms in the barrier (synchronisation)\n",
+         imbal, sync);
+
+  free( compute );
+  free( wait );
+  free( slowest );
+}
+
+void prof_destroy( prof_t * prof ) {
+  unsigned t;
+  for( t = 0; t < prof->threads; t++ ) {
+    free( prof->thread[ t ].c );
+    free( prof->thread[ t ].w );
+  }
+  free( prof->thread );
+  free( prof );
+}
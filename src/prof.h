@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _PROF_H_
+#define _PROF_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+  Load imbalance per timestep (--imbalance): every thread splits the time
+  of its time loop into compute and barrier wait, by CLOCK_MONOTONIC
+  stamps around each SEISMIC_BARRIER(). SEISMIC_STEP() closes the record
+  of a timestep: both sums go into preallocated arrays of the thread, one
+  pair per timestep, so no thread ever touches the lines of another one.
+  Compute is all but the wait, i.e. kernel, pulse and hooks.
+
+  The records of all threads line up by index, hence prof_report() can
+  compare the threads step by step: the slowest one sets the pace, the
+  others wait for it at the barrier.
+*/
+
+#define PROF_LINE     64
+
+typedef struct _prof_thread_t prof_thread_t;
+struct _prof_thread_t {
+  uint64_t last; // ns, the last stamp
+  uint64_t compute; // ns, of the open record
+  uint64_t wait;
+  unsigned n; // records, incl. the ones beyond cap
+  uint64_t * c; // ns per record
+  uint64_t * w;
+} __attribute__((aligned(PROF_LINE)));
+
+typedef struct _prof_t prof_t;
+struct _prof_t {
+  unsigned threads;
+  unsigned cap; // records per thread
+  prof_thread_t * thread;
+};
+
+static inline uint64_t prof_now( void ) {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+#define PROF_BEGIN( prof, id ) \
+  { \
+    prof_thread_t * _th = &(prof)->thread[ (id) ]; \
+    _th->compute = _th->wait = 0; \
+    _th->last = prof_now(); \
+  }
+
+#define PROF_ENTER( prof, id ) \
+  { \
+    prof_thread_t * _th = &(prof)->thread[ (id) ]; \
+    uint64_t _now = prof_now(); \
+    _th->compute += _now - _th->last; \
+    _th->last = _now; \
+  }
+
+#define PROF_LEAVE( prof, id ) \
+  { \
+    prof_thread_t * _th = &(prof)->thread[ (id) ]; \
+    uint64_t _now = prof_now(); \
+    _th->wait += _now - _th->last; \
+    _th->last = _now; \
+  }
+
+#define PROF_STEP( prof, id ) \
+  { \
+    prof_thread_t * _th = &(prof)->thread[ (id) ]; \
+    uint64_t _now = prof_now(); \
+    _th->compute += _now - _th->last; \
+    _th->last = _now; \
+    if( _th->n < (prof)->cap ) { \
+      _th->c[ _th->n ] = _th->compute; \
+      _th->w[ _th->n ] = _th->wait; \
+    } \
+    _th->n++; \
+    _th->compute = _th->wait = 0; \
+  }
+
+prof_t * prof_create( unsigned threads, unsigned timesteps );
+void prof_end( prof_t * prof, unsigned id ); // the rest goes into the last record
+void prof_report( prof_t * prof );
+void prof_destroy( prof_t * prof );
+
+#endif /* #ifndef _PROF_H_ */
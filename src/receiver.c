@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "receiver.h"
+
+#define TRACE_HEADER      240
+#define SEGY_TEXT_HEADER  3200
+#define SEGY_BIN_HEADER   400
+// ns and dt are 16 bit fields in the trace headers
+#define TRACE_MAX_SAMPLES 65535
+#define TRACE_MAX_DT      65535 // us
+
+
+static void receiver_add( receiver_t * r, unsigned * cap, unsigned x, unsigned y ) {
+  if( r->count == *cap ) {
+    *cap = *cap ? *cap * 2 : 256;
+    r->x = (unsigned*) realloc( r->x, *cap * sizeof(unsigned) );
+    r->y = (unsigned*) realloc( r->y, *cap * sizeof(unsigned) );
+    if( r->x == NULL || r->y == NULL ) {
+      fprintf(stderr, "ERROR: receiver allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  r->x[ r->count ] = x;
+  r->y[ r->count ] = y;
+  r->count++;
+}
+
+static void receiver_parse( receiver_t * r, const char * spec ) {
+  unsigned cap = 0, x0, x1, dx, y;
+  char c;
+
+  // a line of receivers ...
+  if( sscanf( spec, "%u:%u:%u@%u%c", &x0, &x1, &dx, &y, &c ) == 4 ) {
+    if( ! dx || x1 < x0 ) {
+      fprintf(stderr, "ERROR: receivers '%s' need x0 <= x1 and dx > 0\n", spec);
+      exit(EXIT_FAILURE);
+    }
+    for( ; x0 <= x1; x0 += dx )
+      receiver_add( r, &cap, x0, y );
+    return;
+  }
+
+  // ... or a file of points
+  FILE * f = fopen( spec, "r" );
+  if( f == NULL ) {
+    fprintf(stderr, "ERROR: receivers '%s' are neither x0:x1:dx@y nor a readable file\n", spec);
+    exit(EXIT_FAILURE);
+  }
+  char line[256];
+  unsigned l = 0;
+  while( fgets( line, sizeof(line), f ) ) {
+    l++;
+    char * p = strchr( line, '#' );
+    if( p )
+      *p = '\0';
+    int n = sscanf( line, "%u %u %c", &x0, &y, &c );
+    if( n == EOF )
+      continue;
+    if( n != 2 ) {
+      fprintf(stderr, "ERROR: %s:%u: expected 'x y'\n", spec, l);
+      exit(EXIT_FAILURE);
+    }
+    receiver_add( r, &cap, x0, y );
+  }
+  fclose( f );
+}
+
+static int receiver_cmp( const void * a, const void * b ) {
+  const unsigned * pa = (const unsigned*) a;
+  const unsigned * pb = (const unsigned*) b;
+  if( pa[0] != pb[0] )
+    return pa[0] < pb[0] ? -1 : 1;
+  return pa[1] < pb[1] ? -1 : pa[1] > pb[1];
+}
+
+receiver_t * receiver_create( const char * spec, unsigned width, unsigned height, unsigned border, unsigned origin, unsigned timesteps, unsigned subsample, double dt ) {
+  receiver_t * r = (receiver_t*) calloc( 1, sizeof(receiver_t) );
+  if( r == NULL )
+    return NULL;
+
+  receiver_parse( r, spec );
+  if( ! r->count ) {
+    fprintf(stderr, "ERROR: no receivers in '%s'\n", spec);
+    exit(EXIT_FAILURE);
+  }
+
+  r->subsample = subsample;
+  r->samples = timesteps / subsample + 1;
+  if( r->samples > TRACE_MAX_SAMPLES || dt * subsample * 1e6 > TRACE_MAX_DT ) {
+    fprintf(stderr, "ERROR: %u samples of %.0f us do not fit into a trace header (max. %u / %u us)\n",
+            r->samples, dt * subsample * 1e6, TRACE_MAX_SAMPLES, TRACE_MAX_DT);
+    exit(EXIT_FAILURE);
+  }
+
+  // sort by (x, y), which is the memory order
+  unsigned * xy = (unsigned*) malloc( 2 * r->count * sizeof(unsigned) );
+  r->offset = (unsigned long*) malloc( r->count * sizeof(unsigned long) );
+  r->trace = (float*) calloc( (unsigned long)r->count * r->samples, sizeof(float) );
+  if( xy == NULL || r->offset == NULL || r->trace == NULL ) {
+    free( xy );
+    receiver_destroy( r );
+    return NULL;
+  }
+
+  unsigned i;
+  for( i = 0; i < r->count; i++ ) {
+    if( r->x[ i ] < origin || r->x[ i ] - origin + 2 * border >= width || r->y[ i ] + 2 * border >= height ) {
+      fprintf(stderr, "ERROR: receiver %u (%u, %u) is outside of the model\n", i, r->x[ i ], r->y[ i ]);
+      exit(EXIT_FAILURE);
+    }
+    xy[ 2 * i ] = r->x[ i ] - origin + border;
+    xy[ 2 * i + 1 ] = r->y[ i ] + border;
+  }
+  qsort( xy, r->count, 2 * sizeof(unsigned), receiver_cmp );
+
+  for( i = 0; i < r->count; i++ ) {
+    r->x[ i ] = xy[ 2 * i ];
+    r->y[ i ] = xy[ 2 * i + 1 ];
+    r->offset[ i ] = (unsigned long)r->x[ i ] * height + r->y[ i ];
+  }
+  free( xy );
+
+  return r;
+}
+
+// receivers with x_start <= x < x_end
+void receiver_range( receiver_t * r, unsigned x_start, unsigned x_end, unsigned * r_start, unsigned * r_end ) {
+  unsigned i = 0;
+  while( i < r->count && r->x[ i ] < x_start )
+    i++;
+  *r_start = i;
+  while( i < r->count && r->x[ i ] < x_end )
+    i++;
+  *r_end = i;
+}
+
+/*
+  SU: native byte order, a 240 byte header per trace.
+  SEG-Y (rev. 2, ASCII text header): big endian, 3200 + 400 byte file header
+  ahead of the same traces, samples in IEEE float (format 5).
+*/
+static void put16( unsigned char * p, int v, int be ) {
+  uint16_t u = (uint16_t)v;
+  if( be ) {
+    p[0] = u >> 8;
+    p[1] = u;
+  }
+  else
+    memcpy( p, &u, sizeof(u) );
+}
+
+static void put32( unsigned char * p, int32_t v, int be ) {
+  uint32_t u = (uint32_t)v;
+  if( be ) {
+    p[0] = u >> 24;
+    p[1] = u >> 16;
+    p[2] = u >> 8;
+    p[3] = u;
+  }
+  else
+    memcpy( p, &u, sizeof(u) );
+}
+
+int receiver_is_segy( const char * file ) {
+  const char * ext = strrchr( file, '.' );
+  return ext && ( ! strcmp( ext, ".sgy" ) || ! strcmp( ext, ".segy" ) );
+}
+
+void receiver_write( receiver_t * r, const char * file, unsigned border, unsigned origin, double h, double dt, unsigned x_src, unsigned y_src ) {
+  int be = receiver_is_segy( file );
+  unsigned dt_us = (unsigned)lrint( dt * r->subsample * 1e6 );
+
+  FILE * f = fopen( file, "wb" );
+  if( f == NULL ) {
+    fprintf(stderr, "ERROR: could not open '%s'\n", file);
+    exit(EXIT_FAILURE);
+  }
+
+  if( be ) {
+    unsigned char text[ SEGY_TEXT_HEADER ], bin[ SEGY_BIN_HEADER ];
+    memset( text, ' ', sizeof(text) );
+    memset( bin, 0, sizeof(bin) );
+
+    char line[81];
+    snprintf( line, sizeof(line), "C 1 SEISMIC-RTM SYNTHETIC SHOT GATHER, %u TRACES", r->count );
+    memcpy( &text[ 0 ], line, strlen( line ) );
+    snprintf( line, sizeof(line), "C 2 SOURCE X %u Y %u, GRID SPACING %g M", x_src - border + origin, y_src - border, h );
+    memcpy( &text[ 80 ], line, strlen( line ) );
+    memcpy( &text[ 39 * 80 ], "C40 END TEXTUAL HEADER", 22 );
+
+    put16( &bin[ 12 ], r->count, be ); // traces per ensemble
+    put16( &bin[ 16 ], dt_us, be );
+    put16( &bin[ 20 ], r->samples, be );
+    put16( &bin[ 24 ], 5, be ); // IEEE float
+    put16( &bin[ 28 ], 1, be ); // as recorded
+    put16( &bin[ 54 ], 1, be ); // meters
+    bin[ 300 ] = 2; // revision 2.0
+    put16( &bin[ 302 ], 1, be ); // fixed trace length
+
+    fwrite( text, 1, sizeof(text), f );
+    fwrite( bin, 1, sizeof(bin), f );
+  }
+
+  int32_t sx = (int32_t)lrint( (x_src - border + origin) * h );
+  int32_t sz = (int32_t)lrint( (y_src - border) * h );
+  uint32_t * samples = (uint32_t*) malloc( r->samples * sizeof(uint32_t) );
+  if( samples == NULL ) {
+    fprintf(stderr, "ERROR: receiver allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  unsigned i, s;
+  for( i = 0; i < r->count; i++ ) {
+    unsigned char hdr[ TRACE_HEADER ];
+    int32_t gx = (int32_t)lrint( (r->x[ i ] - border + origin) * h );
+    int32_t gz = (int32_t)lrint( (r->y[ i ] - border) * h );
+    memset( hdr, 0, sizeof(hdr) );
+
+    put32( &hdr[ 0 ], i + 1, be ); // tracl
+    put32( &hdr[ 4 ], i + 1, be ); // tracr
+    put32( &hdr[ 8 ], 1, be ); // fldr
+    put32( &hdr[ 12 ], i + 1, be ); // tracf
+    put16( &hdr[ 28 ], 1, be ); // trid: seismic data
+    put16( &hdr[ 34 ], 1, be ); // duse: production
+    put32( &hdr[ 36 ], gx - sx, be ); // offset
+    put32( &hdr[ 40 ], -gz, be ); // gelev
+    put32( &hdr[ 48 ], sz, be ); // sdepth
+    put16( &hdr[ 68 ], 1, be ); // scalel
+    put16( &hdr[ 70 ], 1, be ); // scalco
+    put32( &hdr[ 72 ], sx, be );
+    put32( &hdr[ 80 ], gx, be );
+    put16( &hdr[ 88 ], 1, be ); // counit: length
+    put16( &hdr[ 114 ], r->samples, be );
+    put16( &hdr[ 116 ], dt_us, be );
+    fwrite( hdr, 1, sizeof(hdr), f );
+
+    const float * t = &r->trace[ (unsigned long)i * r->samples ];
+    for( s = 0; s < r->samples; s++ ) {
+      int32_t v;
+      memcpy( &v, &t[ s ], sizeof(v) );
+      put32( (unsigned char*) &samples[ s ], v, be );
+    }
+    fwrite( samples, sizeof(float), r->samples, f );
+  }
+
+  free( samples );
+  fclose( f );
+}
+
+void receiver_destroy( receiver_t * r ) {
+  free( r->x );
+  free( r->y );
+  free( r->offset );
+  free( r->trace );
+  free( r );
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _RECEIVER_H_
+#define _RECEIVER_H_
+
+/*
+  Receivers record the wavefield at fixed grid points into one trace each.
+  They are sorted by their offset into the matrices, hence every thread
+  owns a contiguous range of them (the ones inside its x-strip) and walks
+  the wavefield in memory order when sampling.
+
+  spec: "x0:x1:dx@y" for a line of receivers at depth y, otherwise the name
+  of a file with one "x y" pair per line ('#' starts a comment).
+  Coordinates are model coordinates, i.e. without the random boundary, and
+  count from the first model column, even if the grid starts at column
+  'origin' of the model (see --aperture).
+
+  Sample s is the wavefield after timestep s * subsample. Sample 0 is the
+  initial frame as the first timestep reads it, i.e. with pulsevector[ 0 ]
+  or the first row of the injected traces already added.
+*/
+
+typedef struct _receiver_t receiver_t;
+struct _receiver_t {
+  unsigned count;
+  unsigned * x; // grid coordinates, incl. random boundary
+  unsigned * y;
+  unsigned long * offset; // x * height + y, ascending
+
+  unsigned subsample; // record every n-th timestep
+  unsigned samples; // per trace, incl. the initial frame
+  float * trace; // [receiver][sample]
+};
+
+receiver_t * receiver_create( const char * spec, unsigned width, unsigned height, unsigned border, unsigned origin, unsigned timesteps, unsigned subsample, double dt );
+void receiver_range( receiver_t * r, unsigned x_start, unsigned x_end, unsigned * r_start, unsigned * r_end );
+void receiver_write( receiver_t * r, const char * file, unsigned border, unsigned origin, double h, double dt, unsigned x_src, unsigned y_src );
+void receiver_destroy( receiver_t * r );
+int receiver_is_segy( const char * file );
+
+// one sample of the receivers [r_start, r_end)
+#define RECEIVER_RECORD( r, sample, r_start, r_end, apf ) \
+  { \
+    unsigned _i; \
+    for( _i = (r_start); _i < (r_end); _i++ ) \
+      (r)->trace[ (unsigned long)_i * (r)->samples + (sample) ] = (apf)[ (r)->offset[ _i ] ]; \
+  }
+
+#endif /* #ifndef _RECEIVER_H_ */
@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "roofline.h"
+#include "bench.h"
+#ifdef CPU_FEATURES_ARCH_X86_64
+#  include <immintrin.h>
+#endif
+
+#define PEAK_ITERS    (4ul << 20)
+#define PEAK_CHAINS   10 // independent multiply-adds, more than latency * ports
+
+typedef float v4f __attribute__((vector_size(16)));
+
+// the job of all threads, see roofline_thread()
+static struct {
+  enum { JOB_INIT, JOB_COPY, JOB_TRIAD, JOB_PEAK } job;
+  unsigned peak;
+  unsigned threads;
+  float * a;
+  float * b;
+  float * c;
+  double sec; // thread 0, between the barriers
+} job;
+
+static double now( void ) {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// a * m + d converges to 1, no overflow or denormals
+#define PEAK_PROBE( NAME, TYPE, MADD, ATTR ) \
+ATTR static float NAME( unsigned long iters ) { \
+  TYPE m, d, a0, a1, a2, a3, a4, a5, a6, a7, a8, a9; \
+  memset( &m, 0, sizeof(m) ); \
+  m += 0.999999f; d = m - 0.999998f; \
+  a0 = a1 = a2 = a3 = a4 = a5 = a6 = a7 = a8 = a9 = d; \
+  unsigned long i; \
+  for( i = 0; i < iters; i++ ) { \
+    a0 = MADD( a0, m, d ); a1 = MADD( a1, m, d ); a2 = MADD( a2, m, d ); a3 = MADD( a3, m, d ); a4 = MADD( a4, m, d ); \
+    a5 = MADD( a5, m, d ); a6 = MADD( a6, m, d ); a7 = MADD( a7, m, d ); a8 = MADD( a8, m, d ); a9 = MADD( a9, m, d ); \
+  } \
+  a0 += a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8 + a9; \
+  float r; \
+  memcpy( &r, &a0, sizeof(r) ); \
+  return r; \
+}
+
+#define MADD( a, m, d )   ((a) * (m) + (d))
+
+PEAK_PROBE( peak_scalar, float, MADD, )
+PEAK_PROBE( peak_w4, v4f, MADD, )
+#ifdef CPU_FEATURES_ARCH_X86_64
+typedef float v8f __attribute__((vector_size(32)));
+#  define MADD_W4_FMA( a, m, d )  ((v4f)_mm_fmadd_ps( (__m128)(a), (__m128)(m), (__m128)(d) ))
+#  define MADD_W8_FMA( a, m, d )  ((v8f)_mm256_fmadd_ps( (__m256)(a), (__m256)(m), (__m256)(d) ))
+PEAK_PROBE( peak_w4_fma, v4f, MADD_W4_FMA, __attribute__((target("fma"))) )
+PEAK_PROBE( peak_w8, v8f, MADD, __attribute__((target("avx"))) )
+PEAK_PROBE( peak_w8_fma, v8f, MADD_W8_FMA, __attribute__((target("avx,fma"))) )
+#endif
+
+static const char * peak_names[ ROOFLINE_PEAKS ] = { "scalar", "4 floats", "4 floats fma", "8 floats", "8 floats fma" };
+
+static float peak_run( unsigned p ) {
+  switch( p ) {
+    case ROOFLINE_SCALAR: return peak_scalar( PEAK_ITERS );
+    case ROOFLINE_W4: return peak_w4( PEAK_ITERS / 4 );
+#ifdef CPU_FEATURES_ARCH_X86_64
+    case ROOFLINE_W4_FMA: return peak_w4_fma( PEAK_ITERS / 4 );
+    case ROOFLINE_W8: return peak_w8( PEAK_ITERS / 8 );
+    case ROOFLINE_W8_FMA: return peak_w8_fma( PEAK_ITERS / 8 );
+#endif
+  }
+  return 0.0f;
+}
+
+// own slice of the arrays (first touch), like the strips of the run
+static void roofline_thread( void * v ) {
+  stack_t * data = (stack_t*) v;
+  unsigned long part = ROOFLINE_FLOATS / job.threads;
+  unsigned long lo = data->id * part, hi = data->id + 1 == job.threads ? ROOFLINE_FLOATS : lo + part, i;
+  float * a = job.a, * b = job.b, * c = job.c;
+  volatile float sink;
+
+  BARRIER( data->barrier, data->id );
+  double t = now();
+  switch( job.job ) {
+    case JOB_INIT:
+      for( i = lo; i < hi; i++ ) {
+        a[ i ] = 1.0f;
+        b[ i ] = 2.0f;
+        c[ i ] = 0.0f;
+      }
+      break;
+    case JOB_COPY:
+      for( i = lo; i < hi; i++ )
+        c[ i ] = a[ i ];
+      break;
+    case JOB_TRIAD:
+      for( i = lo; i < hi; i++ )
+        a[ i ] = b[ i ] + 3.0f * c[ i ];
+      break;
+    case JOB_PEAK:
+      sink = peak_run( job.peak );
+      (void)sink;
+      break;
+  }
+  BARRIER( data->barrier, data->id );
+  if( ! data->id )
+    job.sec = now() - t;
+}
+
+// best of ROOFLINE_REPS
+static double roofline_job( config_t * config, stack_t * data, unsigned j ) {
+  double best = 0.0;
+  unsigned r;
+  job.job = j;
+  for( r = 0; r < ROOFLINE_REPS; r++ ) {
+    seismic_run( config, data, roofline_thread );
+    if( ! r || job.sec < best )
+      best = job.sec;
+  }
+  return best;
+}
+
+void roofline_measure( config_t * config, stack_t * data, roofline_t * roof ) {
+  memset( roof, 0, sizeof(roofline_t) );
+  job.threads = config->threads;
+  job.a = (float*) malloc( ROOFLINE_FLOATS * sizeof(float) );
+  job.b = (float*) malloc( ROOFLINE_FLOATS * sizeof(float) );
+  job.c = (float*) malloc( ROOFLINE_FLOATS * sizeof(float) );
+  if( job.a == NULL || job.b == NULL || job.c == NULL ) {
+    printf("allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // STREAM counts no write-allocate: copy 2, triad 3 arrays
+  job.job = JOB_INIT;
+  seismic_run( config, data, roofline_thread );
+  roof->copy = 2.0 * ROOFLINE_FLOATS * sizeof(float) / roofline_job( config, data, JOB_COPY ) / 1e9;
+  roof->triad = 3.0 * ROOFLINE_FLOATS * sizeof(float) / roofline_job( config, data, JOB_TRIAD ) / 1e9;
+
+  free( job.a );
+  free( job.b );
+  free( job.c );
+
+  archfeatures cap = check_hw_capabilites();
+  unsigned p;
+  for( p = 0; p < ROOFLINE_PEAKS; p++ ) {
+#ifdef CPU_FEATURES_ARCH_X86_64
+    if( (p == ROOFLINE_W4_FMA && ! cap.in.fma3) || (p == ROOFLINE_W8 && ! cap.in.avx)
+        || (p == ROOFLINE_W8_FMA && ! (cap.in.avx && cap.in.fma3)) )
+      continue;
+#else
+    (void)cap;
+    if( p != ROOFLINE_SCALAR && p != ROOFLINE_W4 )
+      continue;
+#endif
+    job.peak = p;
+    roof->peak[ p ] = (double)config->threads * PEAK_ITERS * PEAK_CHAINS * 2 / roofline_job( config, data, JOB_PEAK ) / 1e9;
+  }
+}
+
+// the multiply-add peak of the vector width (and FMA) of the kernel
+double roofline_peak( const roofline_t * roof, const sym_kernel_t * variant ) {
+  unsigned lanes = variant->vectorwidth / sizeof(float), p = ROOFLINE_SCALAR;
+  unsigned fma = 0;
+#ifdef CPU_FEATURES_ARCH_X86_64
+  fma = variant->cap.in.fma3;
+#endif
+  if( lanes >= 8 )
+    p = fma ? ROOFLINE_W8_FMA : ROOFLINE_W8;
+  else if( lanes >= 4 )
+    p = fma ? ROOFLINE_W4_FMA : ROOFLINE_W4;
+  return roof->peak[ p ] ? roof->peak[ p ] : roof->peak[ ROOFLINE_SCALAR ];
+}
+
+double roofline_bound( const roofline_t * roof, const sym_kernel_t * variant ) {
+  double memory = roof->triad * variant->flops / variant->bytes;
+  double peak = roofline_peak( roof, variant );
+  return memory < peak ? memory : peak;
+}
+
+void roofline_print( const roofline_t * roof ) {
+  printf("(ID=0Z): ROOF   = stream copy %.2f GB/s, triad %.2f GB/s\n", roof->copy, roof->triad);
+  unsigned p;
+  for( p = 0; p < ROOFLINE_PEAKS; p++ )
+    if( roof->peak[ p ] )
+      printf("(ID=0Z): ROOF   = peak %-12s %8.2f GFLOPS, ridge at %.2f flop/B\n",
+             peak_names[ p ], roof->peak[ p ], roof->peak[ p ] / roof->triad);
+}
+
+void roofline_kernel( const roofline_t * roof, const sym_kernel_t * variant, double gflops ) {
+  double ai = (double)variant->flops / variant->bytes, bound = roofline_bound( roof, variant );
+  printf("(ID=0Z): ROOF   = %s: %.3f flop/B, %s bound %.2f GFLOPS, achieved %.2f GFLOPS = %.1f%%%s\n",
+         variant->name, ai, bound < roofline_peak( roof, variant ) ? "memory" : "compute", bound, gflops,
+         bound > 0.0 ? 100.0 * gflops / bound : 0.0, gflops > bound ? " (above the DRAM roof, the matrices fit into the caches)" : "");
+}
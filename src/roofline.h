@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _ROOFLINE_H_
+#define _ROOFLINE_H_
+
+#include "config.h"
+#include "kernel.h"
+
+/*
+  Roofline of this machine (--roofline), measured at start-up with the
+  threads and pinning of the run: STREAM copy and triad bandwidth over
+  arrays far beyond the caches, and the peak of independent multiply-adds
+  per vector width (1, 4 and 8 floats; x86 also with FMA).
+
+  A kernel is bound by min( peak of its vector width, intensity * triad )
+  with the intensity flops / bytes of sym_kernel_t. The achieved GFLOPS
+  are shown as percentage of that bound.
+*/
+
+#define ROOFLINE_FLOATS     (8u << 20) // per stream array
+#define ROOFLINE_REPS       5
+
+enum { ROOFLINE_SCALAR, ROOFLINE_W4, ROOFLINE_W4_FMA, ROOFLINE_W8, ROOFLINE_W8_FMA, ROOFLINE_PEAKS };
+
+typedef struct _roofline_t roofline_t;
+struct _roofline_t {
+  double copy; // GB/s
+  double triad;
+  double peak[ ROOFLINE_PEAKS ]; // GFLOPS, 0: not supported here
+};
+
+void roofline_measure( config_t * config, stack_t * data, roofline_t * roof );
+double roofline_peak( const roofline_t * roof, const sym_kernel_t * variant );
+double roofline_bound( const roofline_t * roof, const sym_kernel_t * variant );
+void roofline_print( const roofline_t * roof );
+void roofline_kernel( const roofline_t * roof, const sym_kernel_t * variant, double gflops );
+
+#endif /* #ifndef _ROOFLINE_H_ */
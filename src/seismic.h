@@ -26,27 +26,88 @@ float ricker_wavelet(float t,float fc) {
     pulsevector[ timesteps ] = 0.0f; /* performance optimisation */ \
   }
 
-#define init_seismic_matrices( width, height, VEL, APF, NPPF, fat ) \
+/*
+  Random velocity boundary (Clapp, 2009): instead of absorbing, the outer
+  'border' points scatter the wavefield with velocities that get more random
+  towards the edge. The propagation stays time-reversible, hence the source
+  wavefield can be recomputed backwards from the last two frames.
+  Velocities get scaled by [0.5, 1.5], capped at vmax (VEL of c_max, see
+  SEISMIC_VEL_MAX): beyond the courant value the boundary would blow up.
+*/
+void init_seismic_randbound( unsigned width, unsigned height, float * VEL, unsigned border, float vmax ) {
+  unsigned seed = 0x5eed; // fixed, so that every run sees the same model
+  unsigned x, y;
+  for( x = 0; x < width; x++ ) {
+    for( y = 0; y < height; y++ ) {
+      unsigned d = x;
+      if( y < d ) d = y;
+      if( width - 1 - x < d ) d = width - 1 - x;
+      if( height - 1 - y < d ) d = height - 1 - y;
+      if( d >= border )
+        continue;
+
+      float frac = (float)(border - d) / (float)border;
+      float c = 1.0f + frac * ((float)rand_r( &seed ) / (float)RAND_MAX - 0.5f);
+      float v = VEL[ (unsigned long)x * height + y ] * c * c; // VEL ~ c^2
+      VEL[ (unsigned long)x * height + y ] = v < vmax ? v : vmax;
+    }
+  }
+}
+
+// VEL may be NULL, if it is loaded from a model instead; APF and NPPF, if they are zero already
+#define init_seismic_matrices( width, height, VEL, APF, NPPF, fat, border ) \
   { \
-    unsigned i; \
-    for( i = 0; i < (height) * (width); i++ ) { \
+    unsigned long i; \
+    for( i = 0; (APF) != NULL && i < (unsigned long)(height) * (width); i++ ) \
       (APF)[ i ] = (NPPF)[ i ] = 0.0f; \
-      (VEL)[ i ] = fat; \
+    if( (VEL) != NULL ) { \
+      for( i = 0; i < (unsigned long)(height) * (width); i++ ) \
+        (VEL)[ i ] = fat; \
+      if( border ) \
+        init_seismic_randbound( (width), (height), (VEL), (border), SEISMIC_VEL_MAX ); \
     } \
   }
 
-#define init_seismic_buffers( width, height, timesteps, VEL, APF, NPPF, pulsevector ) \
+/*
+  Pulse for the time-reversed run of 'timesteps' forward steps:
+  u(n-1) = 2 u(n) - (u(n+1) - pulse(n+1)) + vel * L(u(n)), thus the pulse
+  injected after the backward step s is the forward pulse(timesteps + 1 - s).
+  Every kernel injects pulsevector[ 0 ] before its time loop and
+  pulsevector[ t + 1 ] after the swap of timestep t, hence the last entry,
+  pulsevector[ timesteps ], too. Like in the forward vector that entry is
+  zero, the pulse(2) of the last backward step is added by the caller.
+*/
+#define init_seismic_pulsevector_reversed( rpulsevector, pulsevector, timesteps ) \
+  { \
+    unsigned s; \
+    (rpulsevector)[ 0 ] = 0.0f; \
+    for( s = 1; s < (timesteps) - 1; s++ ) { \
+      (rpulsevector)[ s ] = (pulsevector)[ (timesteps) + 1 - s ]; \
+    } \
+    (rpulsevector)[ (timesteps) - 1 ] = 0.0f; \
+  }
+
+// grid spacing and time step of the model, also needed for the trace headers
+#define SEISMIC_C_MAX     2000
+#define SEISMIC_C_MIN     0.002
+#define SEISMIC_H         2
+#define SEISMIC_DT        (0.606*SEISMIC_H/SEISMIC_C_MAX) /* this is the max value. otherwise it needs to be lower */
+#define SEISMIC_FPEAK     ((float)SEISMIC_H*(float)SEISMIC_C_MIN*5) /* per timestep */
+#define SEISMIC_VEL_MAX   ((float)SEISMIC_C_MAX*(float)SEISMIC_C_MAX*(float)SEISMIC_DT*(float)SEISMIC_DT \
+                           / ((float)SEISMIC_H*(float)SEISMIC_H*12.0f)) /* VEL of c_max */
+
+#define init_seismic_buffers( width, height, timesteps, VEL, APF, NPPF, pulsevector, border ) \
   { \
-    float c_max  = 2000     ; \
-    float c_min  =    0.002 ; \
-    float h      =    2     ; \
-    float fmax = h*c_min*5; \
-    float dt = 0.606*h/c_max; /* this is the max value. otherwise it needs to be lower */ \
+    float c_max  = SEISMIC_C_MAX; \
+    float c_min  = SEISMIC_C_MIN; \
+    float h      = SEISMIC_H; \
+    float fmax = SEISMIC_FPEAK; \
+    float dt = SEISMIC_DT; \
     printf("fmax %f, c_min %f, c_max %f, h %f, dt %f\n", fmax, c_min, c_max, h, dt); \
     init_seismic_pulsevector( (pulsevector), (timesteps), fmax ); \
     float c_avg = (c_max - c_min)/2 + c_min; /* loaded velocity */ \
     printf("courant val: %.12f\n", c_max * dt / h); \
-    init_seismic_matrices( (width), (height), (VEL), (APF), (NPPF), (c_avg*c_avg*dt*dt)/( h * h * 12.0f ) ); \
+    init_seismic_matrices( (width), (height), (VEL), (APF), (NPPF), (c_avg*c_avg*dt*dt)/( h * h * 12.0f ), (border) ); \
   }
 
 
@@ -68,7 +129,7 @@ void * malloc_aligned( size_t len, unsigned alignment ) {
 }
 
 int alloc_seismic_buffers( unsigned width, unsigned height, unsigned timesteps, unsigned alignment, float **VEL, float **APF, float **NPPF, float **pulsevector ) {
-  unsigned long size_matrice = (width * height) * sizeof(float);
+  unsigned long size_matrice = (unsigned long)width * height * sizeof(float);
   if( (*APF = (float*)malloc_aligned( size_matrice, alignment )) != NULL) {
     if( (*NPPF = (float*)malloc_aligned( size_matrice, alignment )) != NULL) {
       if( (*VEL = (float*)malloc_aligned( size_matrice, alignment )) != NULL) {
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "shmring.h"
+
+#define ROUND_UP( x, a )    (((x) + (a) - 1) / (a) * (a))
+
+// not private, the waiters are other processes
+static void shmring_wake( uint32_t * word ) {
+  syscall( SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0 );
+}
+
+shmring_t * shmring_create( const char * name, unsigned width, unsigned height, unsigned every, unsigned frames, unsigned threads ) {
+  shmring_t * ring = (shmring_t*) calloc( 1, sizeof(shmring_t) );
+  if( ring == NULL )
+    return NULL;
+
+  unsigned long stride = ROUND_UP( (unsigned long)width * height * sizeof(float), SHMRING_ALIGN );
+  unsigned long data = ROUND_UP( sizeof(shmring_header_t), SHMRING_ALIGN );
+  ring->len = data + SHMRING_SLOTS * stride;
+  ring->threads = threads;
+
+  // consumers of a previous run keep their (unlinked) object
+  shm_unlink( name );
+  int fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0644 );
+  if( fd < 0 || ftruncate( fd, ring->len ) ) {
+    fprintf(stderr, "ERROR: could not create shared memory '%s'\n", name);
+    if( fd >= 0 ) {
+      close( fd );
+      shm_unlink( name );
+    }
+    free( ring );
+    return NULL;
+  }
+  ring->map = mmap( NULL, ring->len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( ring->map == MAP_FAILED ) {
+    shm_unlink( name );
+    free( ring );
+    return NULL;
+  }
+
+  // zero-filled by ftruncate, the magic comes last
+  shmring_header_t * hdr = ring->hdr = (shmring_header_t*) ring->map;
+  hdr->version = SHMRING_VERSION;
+  hdr->slots = SHMRING_SLOTS;
+  hdr->width = width;
+  hdr->height = height;
+  hdr->every = every;
+  hdr->frames = frames;
+  hdr->stride = stride;
+  hdr->data = data;
+  __atomic_thread_fence( __ATOMIC_RELEASE );
+  memcpy( hdr->magic, SHMRING_MAGIC, sizeof(hdr->magic) );
+  return ring;
+}
+
+void shmring_put( shmring_t * ring, unsigned frame, unsigned x_start, unsigned x_end, const float * frame_src ) {
+  shmring_header_t * hdr = ring->hdr;
+  if( frame >= hdr->frames )
+    return;
+
+  // readers of frame - slots notice, the sequence changes ahead of the data
+  unsigned s = frame % SHMRING_SLOTS;
+  __atomic_store_n( &hdr->seq[ s ], 2 * frame + 1, __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_RELEASE );
+
+  float * slot = (float*) ((char*) ring->map + hdr->data + s * hdr->stride);
+  unsigned long off = (unsigned long)x_start * hdr->height;
+  memcpy( &slot[ off ], &frame_src[ off ], (unsigned long)(x_end - x_start) * hdr->height * sizeof(float) );
+
+  // the last strip completes the frame
+  if( __atomic_add_fetch( &ring->filled[ s ], 1, __ATOMIC_ACQ_REL ) == ring->threads ) {
+    ring->filled[ s ] = 0;
+    __atomic_store_n( &hdr->seq[ s ], 2 * frame + 2, __ATOMIC_RELEASE );
+    __atomic_store_n( &hdr->published, frame + 1, __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &hdr->waiters, __ATOMIC_SEQ_CST ) )
+      shmring_wake( &hdr->published );
+  }
+}
+
+void shmring_close( shmring_t * ring ) {
+  __atomic_store_n( &ring->hdr->done, 1, __ATOMIC_SEQ_CST );
+  shmring_wake( &ring->hdr->published );
+  shmring_detach( ring );
+}
+
+shmring_t * shmring_open( const char * name ) {
+  int fd = shm_open( name, O_RDWR, 0 );
+  if( fd < 0 )
+    return NULL;
+
+  struct stat st;
+  if( fstat( fd, &st ) || (unsigned long)st.st_size < sizeof(shmring_header_t) ) {
+    close( fd );
+    return NULL;
+  }
+
+  shmring_t * ring = (shmring_t*) calloc( 1, sizeof(shmring_t) );
+  if( ring == NULL ) {
+    close( fd );
+    return NULL;
+  }
+  // writable for the count of waiters only
+  ring->len = st.st_size;
+  ring->map = mmap( NULL, ring->len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( ring->map == MAP_FAILED ) {
+    free( ring );
+    return NULL;
+  }
+
+  ring->hdr = (shmring_header_t*) ring->map;
+  if( memcmp( ring->hdr->magic, SHMRING_MAGIC, sizeof(ring->hdr->magic) ) || ring->hdr->version != SHMRING_VERSION
+      || ring->hdr->data + ring->hdr->slots * ring->hdr->stride > ring->len ) {
+    shmring_detach( ring );
+    return NULL;
+  }
+  __atomic_thread_fence( __ATOMIC_ACQUIRE );
+  return ring;
+}
+
+// frames published, more than seen unless the producer is done or timed out
+unsigned shmring_wait( shmring_t * ring, unsigned seen, int timeout_ms ) {
+  shmring_header_t * hdr = ring->hdr;
+  unsigned published = __atomic_load_n( &hdr->published, __ATOMIC_ACQUIRE );
+  if( published != seen || __atomic_load_n( &hdr->done, __ATOMIC_ACQUIRE ) )
+    return published;
+
+  struct timespec timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+  __atomic_add_fetch( &hdr->waiters, 1, __ATOMIC_SEQ_CST );
+  syscall( SYS_futex, &hdr->published, FUTEX_WAIT, seen, &timeout, NULL, 0 );
+  __atomic_sub_fetch( &hdr->waiters, 1, __ATOMIC_SEQ_CST );
+  return __atomic_load_n( &hdr->published, __ATOMIC_ACQUIRE );
+}
+
+// frame in place, NULL: not published or overwritten already
+const float * shmring_frame( shmring_t * ring, unsigned frame ) {
+  shmring_header_t * hdr = ring->hdr;
+  unsigned s = frame % hdr->slots;
+  if( __atomic_load_n( &hdr->seq[ s ], __ATOMIC_ACQUIRE ) != 2 * frame + 2 )
+    return NULL;
+  return (const float*) ((const char*) ring->map + hdr->data + s * hdr->stride);
+}
+
+// after reading a frame: has it been left as is meanwhile?
+int shmring_valid( shmring_t * ring, unsigned frame ) {
+  __atomic_thread_fence( __ATOMIC_ACQUIRE );
+  return __atomic_load_n( &ring->hdr->seq[ frame % ring->hdr->slots ], __ATOMIC_RELAXED ) == 2 * frame + 2;
+}
+
+void shmring_detach( shmring_t * ring ) {
+  munmap( ring->map, ring->len );
+  free( ring );
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _SHMRING_H_
+#define _SHMRING_H_
+
+#include <stdint.h>
+
+/*
+  Live frames for consumers on the same node: a POSIX shared-memory
+  object (shm_open name) holding a header and a ring of 'slots' frames,
+  frame n in slot n % slots, column-major like the matrices (incl. the
+  random boundary).
+
+  The compute threads copy their own strip into the slot and never wait:
+  per slot, seq is 2n + 1 while frame n is written and 2n + 2 once it is
+  complete; the thread completing it bumps 'published' (the futex word)
+  and wakes waiting consumers. A consumer reads a frame in place and
+  checks with shmring_valid() afterwards whether it got overwritten
+  meanwhile (seqlock), so a slow consumer skips frames instead of holding
+  up the propagation. The object stays after the run, until unlinked.
+*/
+
+#define SHMRING_MAGIC     "SRTMRING"
+#define SHMRING_VERSION   1
+#define SHMRING_SLOTS     4
+#define SHMRING_ALIGN     4096
+
+typedef struct _shmring_header_t shmring_header_t;
+struct _shmring_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t slots;
+  uint32_t width; // grid
+  uint32_t height;
+  uint32_t every; // timesteps from frame to frame
+  uint32_t frames; // of the whole run
+  uint64_t stride; // bytes from slot to slot
+  uint64_t data; // offset of slot 0
+
+  uint32_t published; // frames complete, futex word
+  uint32_t waiters; // consumers in futex wait
+  uint32_t done; // producer finished
+  uint32_t seq[ SHMRING_SLOTS ];
+};
+
+typedef struct _shmring_t shmring_t;
+struct _shmring_t {
+  shmring_header_t * hdr;
+  void * map;
+  unsigned long len;
+  unsigned threads; // producer: strips per frame
+  unsigned filled[ SHMRING_SLOTS ]; // producer: strips copied, atomic
+};
+
+// producer, the object 'name' is replaced
+shmring_t * shmring_create( const char * name, unsigned width, unsigned height, unsigned every, unsigned frames, unsigned threads );
+void shmring_put( shmring_t * ring, unsigned frame, unsigned x_start, unsigned x_end, const float * frame_src );
+void shmring_close( shmring_t * ring ); // marks it done, consumers keep reading
+
+// consumer
+shmring_t * shmring_open( const char * name );
+unsigned shmring_wait( shmring_t * ring, unsigned seen, int timeout_ms );
+const float * shmring_frame( shmring_t * ring, unsigned frame );
+int shmring_valid( shmring_t * ring, unsigned frame );
+void shmring_detach( shmring_t * ring );
+
+#endif /* #ifndef _SHMRING_H_ */
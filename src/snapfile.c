@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapfile.h"
+
+#define ROUND_UP( x, a )    (((x) + (a) - 1) / (a) * (a))
+
+void snapfile_init( snapfile_header_t * hdr, unsigned width, unsigned height, unsigned frames, unsigned every, const char * kernel, double dt, double h ) {
+  memset( hdr, 0, sizeof(*hdr) );
+  memcpy( hdr->magic, SNAPFILE_MAGIC, sizeof(hdr->magic) );
+  hdr->version = SNAPFILE_VERSION;
+  hdr->width = width;
+  hdr->height = height;
+  hdr->depth = 1;
+  hdr->frames = frames;
+  hdr->every = every;
+  hdr->chunk_cols = SNAPFILE_CHUNK_BYTES / (height * sizeof(float));
+  if( ! hdr->chunk_cols )
+    hdr->chunk_cols = 1;
+  if( hdr->chunk_cols > width )
+    hdr->chunk_cols = width;
+  hdr->chunks = (width + hdr->chunk_cols - 1) / hdr->chunk_cols;
+  hdr->order = 4;
+  hdr->dt = dt;
+  hdr->h = h;
+  strncpy( hdr->kernel, kernel, sizeof(hdr->kernel) - 1 );
+
+  unsigned long index = (unsigned long)frames * hdr->chunks * sizeof(snapfile_index_t);
+  hdr->data = ROUND_UP( sizeof(*hdr) + index, SNAPFILE_ALIGN );
+}
+
+unsigned long snapfile_chunk_stride( const snapfile_header_t * hdr ) {
+  return ROUND_UP( (unsigned long)hdr->chunk_cols * hdr->height * sizeof(float), SNAPFILE_ALIGN );
+}
+
+static int snapfile_pwrite( int fd, const void * buf, unsigned long len, unsigned long off ) {
+  const char * p = (const char*) buf;
+  while( len ) {
+    ssize_t n = pwrite( fd, p, len, off );
+    if( n <= 0 )
+      return -1;
+    p += n;
+    off += n;
+    len -= n;
+  }
+  return 0;
+}
+
+// header and index, zero padded up to the first frame
+int snapfile_write_header( int fd, const snapfile_header_t * hdr ) {
+  void * h; // aligned, fd may be opened with O_DIRECT
+  if( posix_memalign( &h, SNAPFILE_ALIGN, hdr->data ) )
+    return -1;
+  char * head = (char*) h;
+  memset( head, 0, hdr->data );
+  memcpy( head, hdr, sizeof(*hdr) );
+
+  snapfile_index_t * index = (snapfile_index_t*) &head[ sizeof(*hdr) ];
+  unsigned long stride = snapfile_chunk_stride( hdr );
+  unsigned f, c;
+  for( f = 0; f < hdr->frames; f++ )
+    for( c = 0; c < hdr->chunks; c++ ) {
+      unsigned cols = c + 1 == hdr->chunks ? hdr->width - c * hdr->chunk_cols : hdr->chunk_cols;
+      index[ f * hdr->chunks + c ].offset = hdr->data + ((unsigned long)f * hdr->chunks + c) * stride;
+      index[ f * hdr->chunks + c ].bytes = (unsigned long)cols * hdr->height * sizeof(float);
+    }
+
+  int ret = snapfile_pwrite( fd, head, hdr->data, 0 );
+  free( head );
+  return ret;
+}
+
+// a single frame (hdr->frames == 1), e.g. the final one
+int snapfile_write( const char * file, const snapfile_header_t * hdr, const float * frame ) {
+  int fd = open( file, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  if( fd < 0 )
+    return -1;
+
+  int ret = snapfile_write_header( fd, hdr );
+  unsigned long stride = snapfile_chunk_stride( hdr ), col = (unsigned long)hdr->height * sizeof(float);
+  unsigned c;
+  for( c = 0; ! ret && c < hdr->chunks; c++ ) {
+    unsigned cols = c + 1 == hdr->chunks ? hdr->width - c * hdr->chunk_cols : hdr->chunk_cols;
+    ret = snapfile_pwrite( fd, &frame[ (unsigned long)c * hdr->chunk_cols * hdr->height ], cols * col, hdr->data + c * stride );
+  }
+  // the padding of the last chunk, so that it can be mapped whole
+  if( ! ret && ftruncate( fd, hdr->data + hdr->chunks * stride ) )
+    ret = -1;
+
+  close( fd );
+  return ret;
+}
+
+int snapfile_is( const char * file ) {
+  const char * ext = strrchr( file, '.' );
+  return ext != NULL && ! strcmp( ext, ".snap" );
+}
+
+snapfile_t * snapfile_open( const char * file ) {
+  int fd = open( file, O_RDONLY );
+  if( fd < 0 )
+    return NULL;
+
+  struct stat st;
+  if( fstat( fd, &st ) || (unsigned long)st.st_size < sizeof(snapfile_header_t) ) {
+    close( fd );
+    return NULL;
+  }
+
+  snapfile_t * s = (snapfile_t*) calloc( 1, sizeof(snapfile_t) );
+  if( s == NULL ) {
+    close( fd );
+    return NULL;
+  }
+  s->len = st.st_size;
+  s->map = mmap( NULL, s->len, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( s->map == MAP_FAILED ) {
+    free( s );
+    return NULL;
+  }
+
+  s->hdr = (const snapfile_header_t*) s->map;
+  s->index = (const snapfile_index_t*) &((const char*) s->map)[ sizeof(snapfile_header_t) ];
+  const snapfile_header_t * hdr = s->hdr;
+  if( memcmp( hdr->magic, SNAPFILE_MAGIC, sizeof(hdr->magic) ) || hdr->version != SNAPFILE_VERSION
+      || ! hdr->chunk_cols || hdr->chunks != (hdr->width + hdr->chunk_cols - 1) / hdr->chunk_cols
+      || sizeof(*hdr) + (uint64_t)hdr->frames * hdr->chunks * sizeof(snapfile_index_t) > hdr->data
+      || hdr->data > s->len ) {
+    snapfile_close( s );
+    return NULL;
+  }
+  return s;
+}
+
+// frames of width x height back to back, e.g. a raw movie, as a container
+snapfile_t * snapfile_open_raw( const char * file, unsigned width, unsigned height ) {
+  unsigned long frame = (unsigned long)width * height * sizeof(float);
+  int fd = open( file, O_RDONLY );
+  if( fd < 0 )
+    return NULL;
+
+  struct stat st;
+  if( ! frame || fstat( fd, &st ) || (unsigned long)st.st_size < frame ) {
+    close( fd );
+    return NULL;
+  }
+
+  unsigned f, frames = st.st_size / frame;
+  snapfile_t * s = (snapfile_t*) calloc( 1, sizeof(snapfile_t) );
+  snapfile_header_t * hdr = (snapfile_header_t*) malloc( sizeof(*hdr) + frames * sizeof(snapfile_index_t) );
+  if( s == NULL || hdr == NULL ) {
+    free( s );
+    free( hdr );
+    close( fd );
+    return NULL;
+  }
+  s->len = st.st_size;
+  s->map = mmap( NULL, s->len, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( s->map == MAP_FAILED ) {
+    free( hdr );
+    free( s );
+    return NULL;
+  }
+
+  snapfile_init( hdr, width, height, frames, 0, "raw", 0.0, 0.0 );
+  hdr->chunk_cols = width;
+  hdr->chunks = 1;
+  hdr->data = 0;
+  snapfile_index_t * index = (snapfile_index_t*) &hdr[ 1 ];
+  for( f = 0; f < frames; f++ ) {
+    index[ f ].offset = f * frame;
+    index[ f ].bytes = frame;
+  }
+  s->own = hdr;
+  s->hdr = hdr;
+  s->index = index;
+  return s;
+}
+
+const float * snapfile_chunk( snapfile_t * s, unsigned frame, unsigned chunk ) {
+  if( frame >= s->hdr->frames || chunk >= s->hdr->chunks )
+    return NULL;
+  const snapfile_index_t * i = &s->index[ (unsigned long)frame * s->hdr->chunks + chunk ];
+  if( i->offset + i->bytes > s->len )
+    return NULL; // not (yet) written
+  return (const float*) &((const char*) s->map)[ i->offset ];
+}
+
+// columns [x0, x1) and rows [y0, y1) of a frame, column by column into dst
+int snapfile_window( snapfile_t * s, unsigned frame, unsigned x0, unsigned x1, unsigned y0, unsigned y1, float * dst ) {
+  const snapfile_header_t * hdr = s->hdr;
+  if( x0 >= x1 || x1 > hdr->width || y0 >= y1 || y1 > hdr->height )
+    return -1;
+
+  unsigned x;
+  for( x = x0; x < x1; x++ ) {
+    const float * chunk = snapfile_chunk( s, frame, x / hdr->chunk_cols );
+    if( chunk == NULL )
+      return -1;
+    memcpy( dst, &chunk[ (unsigned long)(x % hdr->chunk_cols) * hdr->height + y0 ], (y1 - y0) * sizeof(float) );
+    dst += y1 - y0;
+  }
+  return 0;
+}
+
+void snapfile_close( snapfile_t * s ) {
+  munmap( s->map, s->len );
+  free( s->own );
+  free( s );
+}
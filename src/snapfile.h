@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _SNAPFILE_H_
+#define _SNAPFILE_H_
+
+#include <stdint.h>
+
+/*
+  Snapshot container (*.snap) for wavefield frames, native byte order:
+
+    header | index | frame 0: chunk 0, chunk 1, ... | frame 1: ... | ...
+
+  Every frame is tiled into chunks of chunk_cols whole columns (the last
+  one may be narrower), each stored column-major like the matrices and
+  starting on a SNAPFILE_ALIGN boundary. Hence a chunk can be mapped on
+  its own and written with O_DIRECT. The index holds offset and length
+  (bytes, without padding) of every chunk, [frame][chunk].
+  Frame f is the wavefield after timestep (f + 1) * every of the grid,
+  incl. the random boundary; model_x0 is the first model column of it.
+*/
+
+#define SNAPFILE_MAGIC        "SRTMSNAP"
+#define SNAPFILE_VERSION      2 // 1: 32 bit data offset
+#define SNAPFILE_ALIGN        4096
+#define SNAPFILE_CHUNK_BYTES  (1 << 20) // chunks of about this size
+
+typedef struct _snapfile_header_t snapfile_header_t;
+struct _snapfile_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t order; // of the stencil in space
+  uint64_t data; // offset of frame 0, bytes, behind the index
+
+  uint32_t width; // grid
+  uint32_t height;
+  uint32_t depth;
+  uint32_t frames;
+  uint32_t every; // timesteps from frame to frame
+  uint32_t chunk_cols;
+  uint32_t chunks; // per frame
+  uint32_t randbound;
+  uint32_t model_x0;
+  uint32_t reserved; // zero
+  double dt; // s
+  double h; // m
+  char kernel[32];
+};
+
+typedef struct _snapfile_index_t snapfile_index_t;
+struct _snapfile_index_t {
+  uint64_t offset;
+  uint64_t bytes;
+};
+
+typedef struct _snapfile_t snapfile_t;
+struct _snapfile_t {
+  void * map; // whole file, read-only
+  unsigned long len;
+  const snapfile_header_t * hdr;
+  const snapfile_index_t * index;
+  void * own; // raw: header and index, NULL: within the map
+};
+
+// writer: header, index, and where frames and chunks go
+void snapfile_init( snapfile_header_t * hdr, unsigned width, unsigned height, unsigned frames, unsigned every, const char * kernel, double dt, double h );
+unsigned long snapfile_chunk_stride( const snapfile_header_t * hdr ); // bytes, incl. padding
+int snapfile_write_header( int fd, const snapfile_header_t * hdr );
+int snapfile_write( const char * file, const snapfile_header_t * hdr, const float * frame );
+int snapfile_is( const char * file );
+
+// reader, only the pages of the requested chunks are read
+snapfile_t * snapfile_open( const char * file );
+snapfile_t * snapfile_open_raw( const char * file, unsigned width, unsigned height ); // raw movie, a chunk per frame
+const float * snapfile_chunk( snapfile_t * s, unsigned frame, unsigned chunk );
+int snapfile_window( snapfile_t * s, unsigned frame, unsigned x0, unsigned x1, unsigned y0, unsigned y1, float * dst );
+void snapfile_close( snapfile_t * s );
+
+#endif /* #ifndef _SNAPFILE_H_ */
@@ -0,0 +1,422 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "snapshot.h"
+#include "trace.h"
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+// zero runs shorter than this stay within the literal run
+#define RLE_MINRUN        32
+// largest quantized residual, beyond the chunk falls back to lossless
+#define QUANT_LIMIT       ((double)(1 << 30))
+
+
+/*
+  byte planes: |b0 b1 b2 b3|b0 b1 b2 b3|... -> |b0 b0 ...|b1 b1 ...|b2 ...|b3 ...|
+  the high planes of small or quantized values are mostly zero.
+*/
+static void shuffle( unsigned char * dst, const unsigned char * src, unsigned long n ) {
+  unsigned long i = 0;
+#ifdef __SSE2__
+  for( ; i + 16 <= n; i += 16 ) {
+    __m128i a[4], b[4];
+    unsigned j;
+    // transpose 16 floats (64 bytes) within each register first ...
+    for( j = 0; j < 4; j++ ) {
+      a[j] = _mm_loadu_si128( (const __m128i*) &src[ 4 * i + 16 * j ] );
+      b[j] = _mm_shuffle_epi32( a[j], 0xd8 );
+      a[j] = _mm_shuffle_epi32( a[j], 0x8d );
+      a[j] = _mm_unpacklo_epi8( b[j], a[j] );
+      b[j] = _mm_shuffle_epi32( a[j], 0x4e );
+      a[j] = _mm_unpacklo_epi16( a[j], b[j] );
+    }
+    // ... then across the registers
+    for( j = 0; j < 2; j++ ) {
+      b[j * 2] = _mm_unpacklo_epi32( a[j * 2], a[j * 2 + 1] );
+      b[j * 2 + 1] = _mm_unpackhi_epi32( a[j * 2], a[j * 2 + 1] );
+    }
+    for( j = 0; j < 2; j++ ) {
+      a[j * 2] = _mm_unpacklo_epi64( b[j], b[j + 2] );
+      a[j * 2 + 1] = _mm_unpackhi_epi64( b[j], b[j + 2] );
+    }
+    for( j = 0; j < 4; j++ )
+      _mm_storeu_si128( (__m128i*) &dst[ j * n + i ], a[j] );
+  }
+#endif
+  for( ; i < n; i++ ) {
+    dst[ i ] = src[ 4 * i ];
+    dst[ n + i ] = src[ 4 * i + 1 ];
+    dst[ 2 * n + i ] = src[ 4 * i + 2 ];
+    dst[ 3 * n + i ] = src[ 4 * i + 3 ];
+  }
+}
+
+static void unshuffle( unsigned char * dst, const unsigned char * src, unsigned long n ) {
+  unsigned long i = 0;
+#ifdef __SSE2__
+  for( ; i + 16 <= n; i += 16 ) {
+    __m128i a[4], b[4];
+    unsigned j;
+    for( j = 0; j < 4; j++ )
+      a[j] = _mm_loadu_si128( (const __m128i*) &src[ j * n + i ] );
+    for( j = 0; j < 2; j++ ) {
+      b[j] = _mm_unpacklo_epi8( a[j * 2], a[j * 2 + 1] );
+      b[2 + j] = _mm_unpackhi_epi8( a[j * 2], a[j * 2 + 1] );
+    }
+    for( j = 0; j < 2; j++ ) {
+      a[j] = _mm_unpacklo_epi16( b[j * 2], b[j * 2 + 1] );
+      a[2 + j] = _mm_unpackhi_epi16( b[j * 2], b[j * 2 + 1] );
+    }
+    _mm_storeu_si128( (__m128i*) &dst[ 4 * i ], a[0] );
+    _mm_storeu_si128( (__m128i*) &dst[ 4 * i + 16 ], a[2] );
+    _mm_storeu_si128( (__m128i*) &dst[ 4 * i + 32 ], a[1] );
+    _mm_storeu_si128( (__m128i*) &dst[ 4 * i + 48 ], a[3] );
+  }
+#endif
+  for( ; i < n; i++ ) {
+    dst[ 4 * i ] = src[ i ];
+    dst[ 4 * i + 1 ] = src[ n + i ];
+    dst[ 4 * i + 2 ] = src[ 2 * n + i ];
+    dst[ 4 * i + 3 ] = src[ 3 * n + i ];
+  }
+}
+
+static unsigned long zero_run( const unsigned char * p, unsigned long n ) {
+  unsigned long i = 0;
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+  for( ; i + 16 <= n; i += 16 ) {
+    unsigned m = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) &p[ i ] ), zero ) );
+    if( m != 0xffff )
+      return i + __builtin_ctz( ~m );
+  }
+#endif
+  for( ; i < n && ! p[ i ]; i++ );
+  return i;
+}
+
+static unsigned long nonzero_run( const unsigned char * p, unsigned long n ) {
+  unsigned long i = 0;
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+  for( ; i + 16 <= n; i += 16 ) {
+    unsigned m = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*) &p[ i ] ), zero ) );
+    if( m )
+      return i + __builtin_ctz( m );
+  }
+#endif
+  for( ; i < n && p[ i ]; i++ );
+  return i;
+}
+
+// token: varint( len << 1 | is_zero_run ), literals follow their token
+static unsigned long put_token( unsigned char * dst, unsigned long len, unsigned zero ) {
+  unsigned long tok = (len << 1) | zero, i = 0;
+  while( tok >= 0x80 ) {
+    dst[ i++ ] = (unsigned char)(tok | 0x80);
+    tok >>= 7;
+  }
+  dst[ i++ ] = (unsigned char)tok;
+  return i;
+}
+
+static unsigned long rle_encode( unsigned char * dst, const unsigned char * src, unsigned long n ) {
+  unsigned long i = 0, lit = 0, len = 0;
+  while( i < n ) {
+    i += nonzero_run( &src[ i ], n - i );
+    unsigned long z = zero_run( &src[ i ], n - i );
+    if( z >= RLE_MINRUN || (z && i + z == n) ) {
+      if( i > lit ) {
+        len += put_token( &dst[ len ], i - lit, 0 );
+        memcpy( &dst[ len ], &src[ lit ], i - lit );
+        len += i - lit;
+      }
+      len += put_token( &dst[ len ], z, 1 );
+      lit = i + z;
+    }
+    i += z;
+  }
+  if( i > lit ) {
+    len += put_token( &dst[ len ], i - lit, 0 );
+    memcpy( &dst[ len ], &src[ lit ], i - lit );
+    len += i - lit;
+  }
+  return len;
+}
+
+static void rle_decode( unsigned char * dst, unsigned long n, const unsigned char * src ) {
+  unsigned long o = 0;
+  while( o < n ) {
+    unsigned long tok = 0, len;
+    unsigned s = 0;
+    do {
+      tok |= (unsigned long)(*src & 0x7f) << s;
+      s += 7;
+    } while( *(src++) & 0x80 );
+
+    len = tok >> 1;
+    if( tok & 0x1 )
+      memset( &dst[ o ], 0, len );
+    else {
+      memcpy( &dst[ o ], src, len );
+      src += len;
+    }
+    o += len;
+  }
+}
+
+/*
+  error-bounded: each value is predicted by the reconstruction of its
+  predecessor (same column, or end of the previous one) and the residual is
+  rounded to a multiple of 2 * error, hence |value - reconstruction| <= error.
+  The reconstruction is rounded to float on both sides, where that breaks the
+  bound (error below the float resolution) the chunk stays lossless.
+*/
+static int quantize( uint32_t * q, const float * src, unsigned long n, float error ) {
+  double step = 2.0 * error, inv = 1.0 / step;
+  float pred = 0.0f;
+  unsigned long i;
+  for( i = 0; i < n; i++ ) {
+    double d = ((double)src[ i ] - pred) * inv;
+    if( ! (fabs( d ) < QUANT_LIMIT) ) // also catches NaN/Inf
+      return -1;
+    int32_t k = (int32_t)lrint( d );
+    float r = (float)((double)pred + (double)k * step);
+    if( fabsf( src[ i ] - r ) > error )
+      return -1;
+    pred = r;
+    q[ i ] = ((uint32_t)k << 1) ^ (uint32_t)(k >> 31); // zigzag, small magnitudes only use the low planes
+  }
+  return 0;
+}
+
+static void dequantize( float * dst, const uint32_t * q, unsigned long n, float error ) {
+  double step = 2.0 * error;
+  float pred = 0.0f;
+  unsigned long i;
+  for( i = 0; i < n; i++ ) {
+    int32_t k = (int32_t)((q[ i ] >> 1) ^ -(q[ i ] & 0x1));
+    pred = (float)((double)pred + (double)k * step);
+    dst[ i ] = pred;
+  }
+}
+
+static void compress_chunk( snapshot_store_t * store, snapshot_chunk_t * c, const float * src, unsigned char * planes, unsigned char * out, uint32_t * q ) {
+  unsigned long n = (unsigned long)(c->x_end - c->x_start) * store->height;
+
+  c->quantized = store->error > 0.0f && ! quantize( q, src, n, store->error );
+  shuffle( planes, c->quantized ? (const unsigned char*)q : (const unsigned char*)src, n );
+  unsigned long len = rle_encode( out, planes, n * sizeof(float) );
+
+  free( c->buf );
+  c->buf = (unsigned char*) malloc( len );
+  if( c->buf == NULL ) {
+    fprintf(stderr, "ERROR: snapshot allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy( c->buf, out, len );
+  c->len = len;
+}
+
+static void decompress_chunk( snapshot_store_t * store, snapshot_chunk_t * c, float * frame, unsigned char * planes, uint32_t * q ) {
+  unsigned long n = (unsigned long)(c->x_end - c->x_start) * store->height;
+  float * dst = &frame[ (unsigned long)c->x_start * store->height ];
+
+  rle_decode( planes, n * sizeof(float), c->buf );
+  if( ! c->quantized )
+    unshuffle( (unsigned char*)dst, planes, n );
+  else {
+    unshuffle( (unsigned char*)q, planes, n );
+    dequantize( dst, q, n, store->error );
+  }
+}
+
+static void * snapshot_worker( void * v ) {
+  snapshot_store_t * store = (snapshot_store_t*) v;
+  unsigned tr = TRACE_THREAD( "snapshot worker" );
+
+  // scratch, RLE output may exceed its input by one token per RLE_MINRUN bytes
+  unsigned long n = store->pool_floats;
+  unsigned char * planes = (unsigned char*) malloc( n * sizeof(float) );
+  unsigned char * out = (unsigned char*) malloc( n * sizeof(float) * 2 + 64 );
+  uint32_t * q = (uint32_t*) malloc( n * sizeof(uint32_t) );
+  if( planes == NULL || out == NULL || q == NULL ) {
+    fprintf(stderr, "ERROR: snapshot allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  pthread_mutex_lock( &store->lock );
+  while( 1 ) {
+    while( store->queue_head == store->queue_tail && ! store->quit )
+      pthread_cond_wait( &store->cond, &store->lock );
+    if( store->queue_head == store->queue_tail )
+      break;
+
+    snapshot_job_t job = store->queue[ store->queue_head ];
+    store->queue_head = (store->queue_head + 1) % store->queue_len;
+    pthread_mutex_unlock( &store->lock );
+
+    snapshot_chunk_t * c = &store->chunk[ job.frame * store->chunks + job.chunk ];
+    TRACE_START( tr );
+    if( job.src )
+      compress_chunk( store, c, job.src, planes, out, q );
+    else
+      decompress_chunk( store, c, job.dst, planes, q );
+    TRACE_MARK( tr, TRACE_COMPRESS, job.frame * store->chunks + job.chunk );
+
+    pthread_mutex_lock( &store->lock );
+    if( job.src ) {
+      store->pool[ store->pool_c++ ] = job.src;
+      store->raw += (unsigned long)(c->x_end - c->x_start) * store->height * sizeof(float);
+      store->packed += c->len;
+    }
+    store->pending--;
+    pthread_cond_broadcast( &store->cond );
+  }
+  pthread_mutex_unlock( &store->lock );
+
+  free( planes );
+  free( out );
+  free( q );
+  return NULL;
+}
+
+// expects the lock to be held
+static void snapshot_enqueue( snapshot_store_t * store, snapshot_job_t job ) {
+  store->queue[ store->queue_tail ] = job;
+  store->queue_tail = (store->queue_tail + 1) % store->queue_len;
+  store->pending++;
+  pthread_cond_broadcast( &store->cond );
+}
+
+// the first 'started' workers are running
+static void snapshot_store_free( snapshot_store_t * store, unsigned started ) {
+  unsigned i;
+
+  if( started ) {
+    pthread_mutex_lock( &store->lock );
+    store->quit = 1;
+    pthread_cond_broadcast( &store->cond );
+    pthread_mutex_unlock( &store->lock );
+  }
+  for( i = 0; i < started; i++ )
+    pthread_join( store->workers[ i ], NULL );
+
+  for( i = 0; store->chunk != NULL && i < store->frames * store->chunks; i++ )
+    free( store->chunk[ i ].buf );
+  for( i = 0; store->pool != NULL && i < store->pool_c; i++ )
+    free( store->pool[ i ] );
+
+  pthread_mutex_destroy( &store->lock );
+  pthread_cond_destroy( &store->cond );
+  free( store->chunk );
+  free( store->queue );
+  free( store->pool );
+  free( store->workers );
+  free( store );
+}
+
+snapshot_store_t * snapshot_store_create( unsigned width, unsigned height, unsigned frames, unsigned chunks, unsigned max_cols, float error, unsigned workers ) {
+  snapshot_store_t * store = (snapshot_store_t*) calloc( 1, sizeof(snapshot_store_t) );
+  if( store == NULL )
+    return NULL;
+
+  store->width = width;
+  store->height = height;
+  store->frames = frames;
+  store->chunks = chunks;
+  store->error = error;
+  store->pool_floats = (unsigned long)max_cols * height;
+  store->pool_c = 2 * chunks; // double buffered per compute thread
+  store->queue_len = store->pool_c + chunks + 1;
+  store->workers_c = workers ? workers : 1;
+  pthread_mutex_init( &store->lock, NULL );
+  pthread_cond_init( &store->cond, NULL );
+
+  store->chunk = (snapshot_chunk_t*) calloc( (unsigned long)frames * chunks, sizeof(snapshot_chunk_t) );
+  store->queue = (snapshot_job_t*) malloc( store->queue_len * sizeof(snapshot_job_t) );
+  store->pool = (float**) calloc( store->pool_c, sizeof(float*) );
+  store->workers = (pthread_t*) malloc( store->workers_c * sizeof(pthread_t) );
+  if( store->chunk == NULL || store->queue == NULL || store->pool == NULL || store->workers == NULL ) {
+    snapshot_store_free( store, 0 );
+    return NULL;
+  }
+
+  unsigned i;
+  for( i = 0; i < store->pool_c; i++ ) {
+    if( (store->pool[ i ] = (float*) malloc( store->pool_floats * sizeof(float) )) == NULL ) {
+      snapshot_store_free( store, 0 );
+      return NULL;
+    }
+  }
+
+  for( i = 0; i < store->workers_c; i++ ) {
+    if( pthread_create( &store->workers[ i ], NULL, snapshot_worker, (void*) store ) ) {
+      snapshot_store_free( store, i );
+      return NULL;
+    }
+  }
+  return store;
+}
+
+/*
+  called by the compute threads, each one for its own columns. Only blocks
+  if the workers fall behind by more than two frames.
+*/
+void snapshot_store_put( snapshot_store_t * store, unsigned frame, unsigned chunk, unsigned x_start, unsigned x_end, const float * frame_src ) {
+  if( frame >= store->frames )
+    return;
+
+  pthread_mutex_lock( &store->lock );
+  while( ! store->pool_c )
+    pthread_cond_wait( &store->cond, &store->lock );
+  float * buf = store->pool[ --store->pool_c ];
+  pthread_mutex_unlock( &store->lock );
+
+  snapshot_chunk_t * c = &store->chunk[ frame * store->chunks + chunk ];
+  c->x_start = x_start;
+  c->x_end = x_end;
+  memcpy( buf, &frame_src[ (unsigned long)x_start * store->height ], (unsigned long)(x_end - x_start) * store->height * sizeof(float) );
+
+  pthread_mutex_lock( &store->lock );
+  snapshot_job_t job = { .frame = frame, .chunk = chunk, .src = buf, .dst = NULL };
+  snapshot_enqueue( store, job );
+  pthread_mutex_unlock( &store->lock );
+}
+
+void snapshot_store_wait( snapshot_store_t * store ) {
+  pthread_mutex_lock( &store->lock );
+  while( store->pending )
+    pthread_cond_wait( &store->cond, &store->lock );
+  pthread_mutex_unlock( &store->lock );
+}
+
+// decompresses all chunks of a frame in parallel, columns not kept stay untouched
+void snapshot_store_get( snapshot_store_t * store, unsigned frame, float * frame_dst ) {
+  unsigned i;
+
+  snapshot_store_wait( store );
+
+  pthread_mutex_lock( &store->lock );
+  for( i = 0; i < store->chunks; i++ ) {
+    if( store->chunk[ frame * store->chunks + i ].buf == NULL )
+      continue;
+    snapshot_job_t job = { .frame = frame, .chunk = i, .src = NULL, .dst = frame_dst };
+    snapshot_enqueue( store, job );
+  }
+  pthread_mutex_unlock( &store->lock );
+
+  snapshot_store_wait( store );
+}
+
+void snapshot_store_destroy( snapshot_store_t * store ) {
+  snapshot_store_wait( store );
+  snapshot_store_free( store, store->workers_c );
+}
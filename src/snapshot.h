@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <pthread.h>
+
+/*
+  Compressed in-memory store for wavefield frames.
+
+  A frame is split into chunks of whole columns, one per compute thread
+  strip. A compute thread only copies its strip into a pooled buffer, the
+  (de)compression itself runs on the worker threads of the store:
+   - lossless: byte planes are shuffled (SSE2) and coded with a zero-run RLE,
+     which catches the untouched regions ahead of the wavefront.
+   - lossy: values are quantized against their predecessor with a step of
+     2 * error (error-bounded), then coded like the lossless mode.
+
+  Its only consumer is --keep, the frames kept in memory for the imaging
+  of a reverse run, which seismic-rtm.elf itself does not do: it only
+  checks the final frame against the bound. The movie, checkpoint and shm
+  writers need every frame exactly and on disk / in shared memory as it
+  is, so they stage the strips in their own buffers instead.
+*/
+
+#define SNAPSHOT_LOSSLESS 0.0f
+
+typedef struct _snapshot_chunk_t snapshot_chunk_t;
+struct _snapshot_chunk_t {
+  unsigned x_start; // columns
+  unsigned x_end;
+  unsigned quantized; // 0: lossless, 1: error-bounded
+  unsigned long len; // bytes in buf
+  unsigned char * buf;
+};
+
+typedef struct _snapshot_job_t snapshot_job_t;
+struct _snapshot_job_t {
+  unsigned frame;
+  unsigned chunk;
+  float * src; // compress from, pooled buffer
+  float * dst; // decompress to, whole frame
+};
+
+typedef struct _snapshot_store_t snapshot_store_t;
+struct _snapshot_store_t {
+  unsigned width;
+  unsigned height;
+  unsigned frames;
+  unsigned chunks;
+  float error;
+
+  snapshot_chunk_t * chunk; // frames * chunks
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond; // jobs queued / buffers returned / jobs done
+
+  snapshot_job_t * queue; // ring
+  unsigned queue_len;
+  unsigned queue_head;
+  unsigned queue_tail;
+  unsigned pending; // queued or in progress
+  unsigned quit;
+
+  float ** pool; // free staging buffers (stack)
+  unsigned pool_c;
+  unsigned long pool_floats;
+
+  pthread_t * workers;
+  unsigned workers_c;
+
+  unsigned long raw; // bytes, statistics
+  unsigned long packed;
+};
+
+snapshot_store_t * snapshot_store_create( unsigned width, unsigned height, unsigned frames, unsigned chunks, unsigned max_cols, float error, unsigned workers );
+void snapshot_store_put( snapshot_store_t * store, unsigned frame, unsigned chunk, unsigned x_start, unsigned x_end, const float * frame_src );
+void snapshot_store_get( snapshot_store_t * store, unsigned frame, float * frame_dst );
+void snapshot_store_wait( snapshot_store_t * store );
+void snapshot_store_destroy( snapshot_store_t * store );
+
+#endif /* #ifndef _SNAPSHOT_H_ */
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+trace_t * seismic_trace = NULL;
+
+static const char * trace_names[ TRACE_KINDS ] = { "kernel", "barrier", "cpml", "inject", "receivers", "snapshot copy",
+                                                   "movie copy", "checkpoint copy", "shm copy", "compress", "read", "write" };
+static const char * trace_cats[ TRACE_KINDS ] = { "compute", "sync", "hook", "hook", "hook", "hook",
+                                                  "hook", "hook", "hook", "compute", "io", "io" };
+static const char * trace_args[ TRACE_KINDS ] = { "step", "step", "step", "step", "step", "step",
+                                                  "step", "step", "step", "n", "n", "n" }; // timestep, or chunk, task, frame
+
+trace_t * trace_create( unsigned threads ) {
+  trace_t * trace = (trace_t*) calloc( 1, sizeof(trace_t) );
+  if( trace == NULL )
+    return NULL;
+  trace->threads = threads;
+  trace->slots = threads + TRACE_AUX;
+  if( posix_memalign( (void**)&trace->thread, PROF_LINE, trace->slots * sizeof(trace_thread_t) ) ) {
+    free( trace );
+    return NULL;
+  }
+  memset( trace->thread, 0, trace->slots * sizeof(trace_thread_t) );
+
+  // the rings of the other tracks once claimed
+  unsigned t;
+  for( t = 0; t < threads; t++ ) {
+    if( (trace->thread[ t ].ev = (trace_event_t*) malloc( TRACE_EVENTS * sizeof(trace_event_t) )) == NULL ) {
+      trace_destroy( trace );
+      return NULL;
+    }
+  }
+  trace->t0 = prof_now();
+  return trace;
+}
+
+unsigned trace_claim( trace_t * trace, const char * name ) {
+  unsigned t = trace->threads + __atomic_fetch_add( &trace->claimed, 1, __ATOMIC_RELAXED );
+  if( t >= trace->slots )
+    return trace->slots;
+  trace->thread[ t ].name = name;
+  trace->thread[ t ].ev = (trace_event_t*) malloc( TRACE_EVENTS * sizeof(trace_event_t) );
+  trace->thread[ t ].last = prof_now();
+  return t;
+}
+
+// complete events ("X") in us, one track (tid) per thread
+int trace_write( trace_t * trace, const char * file ) {
+  FILE * f = fopen( file, "w" );
+  if( f == NULL )
+    return -1;
+
+  fprintf( f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+              "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"seismic-rtm\"}}" );
+  unsigned t;
+  for( t = 0; t < trace->slots; t++ ) {
+    trace_thread_t * th = &trace->thread[ t ];
+    if( th->ev == NULL )
+      continue;
+    if( th->name )
+      fprintf( f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", t, th->name );
+    else
+      fprintf( f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", t, t );
+    fprintf( f, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}", t, t );
+
+    unsigned long i = th->n > TRACE_EVENTS ? th->n - TRACE_EVENTS : 0;
+    for( ; i < th->n; i++ ) {
+      trace_event_t * e = &th->ev[ i & (TRACE_EVENTS - 1) ];
+      fprintf( f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"%s\":%u}}",
+               trace_names[ e->kind ], trace_cats[ e->kind ], t, (e->begin - trace->t0) / 1e3, (e->end - e->begin) / 1e3,
+               trace_args[ e->kind ], e->arg );
+    }
+  }
+  fprintf( f, "\n]}\n" );
+  return fclose( f ) ? -1 : 0;
+}
+
+void trace_destroy( trace_t * trace ) {
+  unsigned t;
+  for( t = 0; t < trace->slots; t++ )
+    free( trace->thread[ t ].ev );
+  free( trace->thread );
+  free( trace );
+}
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+#include "prof.h" // prof_now()
+
+/*
+  Timeline of the run (--timeline), written as Chrome trace JSON for
+  Perfetto or chrome://tracing. Only built with -DSEISMIC_TRACE=ON;
+  otherwise all TRACE_* macros are empty and nothing is recorded.
+
+  Every thread owns a ring of TRACE_EVENTS events, the oldest ones get
+  overwritten. TRACE_MARK() closes a slice: the time since the previous
+  mark (or TRACE_START()) of the thread was spent on 'kind'. The compute
+  threads mark kernel and barrier wait in SEISMIC_BARRIER() / _STEP()
+  and each hook in seismic_hook(); the pulse is a single store within
+  the kernel slice. Writer and worker threads claim their own track with
+  TRACE_THREAD() and mark their reads, writes and compression.
+*/
+
+#define TRACE_EVENTS    (1u << 16) // per thread, a power of 2
+#define TRACE_AUX       16 // tracks of writer and worker threads
+
+enum { TRACE_KERNEL, TRACE_BARRIER, TRACE_PML, TRACE_INJECT, TRACE_RECEIVER, TRACE_SNAPSHOT, TRACE_MOVIE,
+       TRACE_CHECKPOINT, TRACE_SHM, TRACE_COMPRESS, TRACE_READ, TRACE_WRITE, TRACE_KINDS };
+
+typedef struct _trace_event_t trace_event_t;
+struct _trace_event_t {
+  uint64_t begin; // ns
+  uint64_t end;
+  unsigned kind;
+  unsigned arg; // timestep, frame or task
+};
+
+typedef struct _trace_thread_t trace_thread_t;
+struct _trace_thread_t {
+  uint64_t last; // ns, the last mark
+  unsigned long n; // events, incl. the overwritten ones
+  trace_event_t * ev;
+  const char * name; // NULL: compute thread
+} __attribute__((aligned(PROF_LINE)));
+
+typedef struct _trace_t trace_t;
+struct _trace_t {
+  unsigned threads; // compute threads, tracks [0, threads)
+  unsigned slots; // plus TRACE_AUX
+  unsigned claimed; // tracks of TRACE_THREAD()
+  uint64_t t0;
+  trace_thread_t * thread;
+};
+
+extern trace_t * seismic_trace; // NULL: no --timeline
+
+static inline void trace_mark( trace_t * trace, unsigned tid, unsigned kind, unsigned arg ) {
+  if( tid >= trace->slots || trace->thread[ tid ].ev == NULL )
+    return;
+  trace_thread_t * th = &trace->thread[ tid ];
+  trace_event_t * e = &th->ev[ th->n++ & (TRACE_EVENTS - 1) ];
+  e->begin = th->last;
+  e->end = th->last = prof_now();
+  e->kind = kind;
+  e->arg = arg;
+}
+
+#ifdef SEISMIC_TRACE
+#  define TRACE_THREAD( name )   (seismic_trace ? trace_claim( seismic_trace, (name) ) : 0u)
+#  define TRACE_START( tid ) \
+  { \
+    if( seismic_trace && (tid) < seismic_trace->slots ) \
+      seismic_trace->thread[ (tid) ].last = prof_now(); \
+  }
+#  define TRACE_MARK( tid, kind, arg ) \
+  { \
+    if( seismic_trace ) \
+      trace_mark( seismic_trace, (tid), (kind), (arg) ); \
+  }
+#else
+#  define TRACE_THREAD( name )          0u
+#  define TRACE_START( tid )            (void)(tid)
+#  define TRACE_MARK( tid, kind, arg )  (void)(tid)
+#endif
+
+trace_t * trace_create( unsigned threads );
+unsigned trace_claim( trace_t * trace, const char * name ); // a track of its own, slots: none left
+int trace_write( trace_t * trace, const char * file );
+void trace_destroy( trace_t * trace );
+
+#endif /* #ifndef _TRACE_H_ */
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "kernel.h"
+#include "velocity.h"
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#define TRACE_HEADER      240
+#define SEGY_FILE_HEADER  3600
+
+
+static int has_ext( const char * file, const char * ext ) {
+  const char * e = strrchr( file, '.' );
+  return e && ! strcmp( e, ext );
+}
+
+static unsigned get16be( const unsigned char * p ) {
+  return (p[0] << 8) | p[1];
+}
+
+static uint32_t get32be( const unsigned char * p ) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static float ibm2ieee( uint32_t u ) {
+  uint32_t frac = u & 0xffffff;
+  if( ! frac )
+    return 0.0f;
+  // 0.frac * 16^(exp - 64)
+  float v = (float)ldexp( (double)frac, 4 * (int)((u >> 24) & 0x7f) - 256 - 24 );
+  return (u >> 31) ? -v : v;
+}
+
+velocity_t * velocity_open( const char * file, unsigned width, unsigned height, unsigned border, unsigned origin, float coef ) {
+  int fd = open( file, O_RDONLY );
+  struct stat st;
+  if( fd < 0 || fstat( fd, &st ) ) {
+    fprintf(stderr, "ERROR: could not open velocity model '%s'\n", file);
+    exit(EXIT_FAILURE);
+  }
+
+  velocity_t * model = (velocity_t*) calloc( 1, sizeof(velocity_t) );
+  if( model == NULL ) {
+    close( fd );
+    return NULL;
+  }
+  model->len = st.st_size;
+  model->width = width;
+  model->height = height;
+  model->border = border;
+  model->coef = coef;
+
+  model->map = model->len ? mmap( NULL, model->len, PROT_READ, MAP_PRIVATE, fd, 0 ) : MAP_FAILED;
+  close( fd );
+  if( model->map == MAP_FAILED ) {
+    fprintf(stderr, "ERROR: could not map velocity model '%s'\n", file);
+    exit(EXIT_FAILURE);
+  }
+  // every thread streams through its own columns
+  madvise( model->map, model->len, MADV_SEQUENTIAL );
+
+  const unsigned char * p = (const unsigned char*) model->map;
+  unsigned long need, ns = height;
+  if( has_ext( file, ".sgy" ) || has_ext( file, ".segy" ) ) {
+    if( model->len < SEGY_FILE_HEADER ) {
+      fprintf(stderr, "ERROR: '%s' has no SEG-Y file header\n", file);
+      exit(EXIT_FAILURE);
+    }
+    unsigned fmt = get16be( &p[ 3224 ] );
+    if( fmt != 1 && fmt != 5 ) {
+      fprintf(stderr, "ERROR: '%s' has sample format %u, only IBM (1) and IEEE (5) floats\n", file, fmt);
+      exit(EXIT_FAILURE);
+    }
+    ns = get16be( &p[ 3220 ] );
+    model->format = fmt == 1 ? VELOCITY_IBM : VELOCITY_BIG_ENDIAN;
+    model->first = &p[ SEGY_FILE_HEADER + TRACE_HEADER ];
+    model->stride = TRACE_HEADER + ns * sizeof(float);
+    need = SEGY_FILE_HEADER + (unsigned long)(origin + width) * model->stride;
+  }
+  else if( has_ext( file, ".su" ) ) {
+    if( model->len >= TRACE_HEADER ) {
+      uint16_t n;
+      memcpy( &n, &p[ 114 ], sizeof(n) );
+      ns = n;
+    }
+    model->format = VELOCITY_NATIVE;
+    model->first = &p[ TRACE_HEADER ];
+    model->stride = TRACE_HEADER + ns * sizeof(float);
+    need = (unsigned long)(origin + width) * model->stride;
+  }
+  else {
+    model->format = VELOCITY_NATIVE;
+    model->first = p;
+    model->stride = height * sizeof(float);
+    need = (unsigned long)(origin + width) * model->stride;
+  }
+
+  if( ns != height || model->len < need ) {
+    fprintf(stderr, "ERROR: velocity model '%s' needs %u columns of %u values\n", file, origin + width, height);
+    exit(EXIT_FAILURE);
+  }
+  model->first += (unsigned long)origin * model->stride;
+
+  return model;
+}
+
+// dst = v^2 * coef, with v decoded from src
+static void velocity_column( float * dst, const unsigned char * src, unsigned n, unsigned format, float coef ) {
+  unsigned i = 0;
+#ifdef __SSE2__
+  if( format != VELOCITY_IBM ) {
+    __m128 c = _mm_set1_ps( coef );
+    for( ; i + 4 <= n; i += 4 ) {
+      __m128i u = _mm_loadu_si128( (const __m128i*) &src[ 4 * i ] );
+      if( format == VELOCITY_BIG_ENDIAN ) {
+        // swap the 16 bit halves, then the bytes within
+        u = _mm_shufflehi_epi16( _mm_shufflelo_epi16( u, 0xb1 ), 0xb1 );
+        u = _mm_or_si128( _mm_slli_epi16( u, 8 ), _mm_srli_epi16( u, 8 ) );
+      }
+      __m128 v = _mm_castsi128_ps( u );
+      _mm_storeu_ps( &dst[ i ], _mm_mul_ps( _mm_mul_ps( v, v ), c ) );
+    }
+  }
+#endif
+  for( ; i < n; i++ ) {
+    float v;
+    if( format == VELOCITY_NATIVE )
+      memcpy( &v, &src[ 4 * i ], sizeof(v) );
+    else {
+      uint32_t u = get32be( &src[ 4 * i ] );
+      if( format == VELOCITY_IBM )
+        v = ibm2ieee( u );
+      else
+        memcpy( &v, &u, sizeof(v) );
+    }
+    dst[ i ] = v * v * coef;
+  }
+}
+
+void velocity_convert( void * v ) {
+  stack_t * data = (stack_t*) v;
+  velocity_t * model = data->model;
+  unsigned border = model->border, x, y;
+
+  for( x = STRIP_X_START( data ); x < STRIP_X_END( data ); x++ ) {
+    // the random boundary repeats the outermost model values
+    unsigned mx = x < border ? 0 : x - border;
+    if( mx >= model->width )
+      mx = model->width - 1;
+
+    float * col = &data->vel[ (unsigned long)x * data->height ];
+    velocity_column( &col[ border ], &model->first[ mx * model->stride ], model->height, model->format, model->coef );
+    for( y = 0; y < border; y++ ) {
+      col[ y ] = col[ border ];
+      col[ border + model->height + y ] = col[ border + model->height - 1 ];
+    }
+  }
+}
+
+void velocity_close( velocity_t * model ) {
+  munmap( model->map, model->len );
+  free( model );
+}
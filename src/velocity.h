@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+#ifndef _VELOCITY_H_
+#define _VELOCITY_H_
+
+#include <stddef.h>
+
+/*
+  Velocity model in m/s, one column (trace) per x and model_height values
+  each. The file is mapped read-only and every compute thread converts the
+  columns of its own strip into VEL coefficients (v^2 dt^2 / 12h^2), which
+  also places the pages of VEL next to the thread that works on them.
+  The random boundary takes the velocities of the nearest model point.
+  Only the columns [origin, origin + width) of the file are used (and read).
+
+  formats, by file name:
+   - *.su:           SU, native byte order
+   - *.sgy, *.segy:  SEG-Y, big endian, IEEE (5) or IBM (1) floats
+   - otherwise:      raw float32, native byte order
+*/
+
+enum { VELOCITY_NATIVE, VELOCITY_BIG_ENDIAN, VELOCITY_IBM };
+
+typedef struct _velocity_t velocity_t;
+struct _velocity_t {
+  void * map;
+  size_t len;
+
+  const unsigned char * first; // first value of column 'origin'
+  unsigned long stride; // bytes from column to column
+  unsigned format;
+
+  unsigned width; // model, without random boundary
+  unsigned height;
+  unsigned border;
+  float coef; // dt^2 / 12h^2
+};
+
+velocity_t * velocity_open( const char * file, unsigned width, unsigned height, unsigned border, unsigned origin, float coef );
+void velocity_convert( void * v ); // per thread, see seismic_run()
+void velocity_close( velocity_t * model );
+
+#endif /* #ifndef _VELOCITY_H_ */
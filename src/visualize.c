@@ -4,6 +4,64 @@
 #include "visualize.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// frames mapped from ofile.0 and ofile.1, see map_matrices()
+static float * map_buf[ 2 ];
+static char * map_file[ 2 ];
+static unsigned long map_len;
+
+/*
+  APF and NPPF as shared mappings of two files next to the output, either
+  one may hold the final frame. write_matrice() renames that one into the
+  output, so the frame reaches the file through the page cache during the
+  run and needs no write pass at the end. No randbound and no aperture:
+  the output is the grid as is.
+*/
+int map_matrices( config_t * config, float ** apf, float ** nppf ) {
+  map_len = (unsigned long)config->height * config->width * config->depth * sizeof(float);
+
+  unsigned i;
+  for( i = 0; i < 2; i++ ) {
+    map_file[ i ] = (char*) malloc( strlen( config->ofile ) + sizeof(".0") );
+    if( map_file[ i ] == NULL )
+      return -1;
+    sprintf( map_file[ i ], "%s.%u", config->ofile, i );
+
+    int fd = open( map_file[ i ], O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 )
+      return -1;
+    // blocks reserved now, a full disk would be a SIGBUS within the run
+    if( posix_fallocate( fd, 0, map_len ) ) {
+      close( fd );
+      return -1;
+    }
+    // all pages at once, instead of a fault per page during the first timestep
+    void * m = mmap( NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0 );
+    close( fd );
+    if( m == MAP_FAILED )
+      return -1;
+    map_buf[ i ] = (float*) m;
+  }
+
+  *apf = map_buf[ 0 ];
+  *nppf = map_buf[ 1 ];
+  return 0;
+}
+
+void unmap_matrices( void ) {
+  unsigned i;
+  for( i = 0; i < 2; i++ ) {
+    if( map_buf[ i ] != NULL )
+      munmap( map_buf[ i ], map_len );
+    free( map_file[ i ] );
+    map_buf[ i ] = NULL;
+    map_file[ i ] = NULL;
+  }
+}
 
 void write_matrice( config_t * config, float * apf, float * nppf ) {
   float * matrice;
@@ -12,11 +70,42 @@ void write_matrice( config_t * config, float * apf, float * nppf ) {
   else
     matrice = apf;
 
+  if( config->mapped ) {
+    // written back like any other dirty page, the other frame is dropped
+    unsigned i = matrice == map_buf[ 0 ] ? 0 : 1;
+    if( msync( matrice, map_len, MS_ASYNC ) || rename( map_file[ i ], config->ofile ) )
+      exit(EXIT_FAILURE);
+    unlink( map_file[ 1 - i ] );
+    return;
+  }
+
   FILE * f1 = fopen( config->ofile, "wb" );
   if( f1 == NULL )
     exit(EXIT_FAILURE);
 
-  fwrite( matrice, sizeof(float), (unsigned long)config->height * (unsigned long)config->width, f1 );
+  // outside of the aperture the wavefield is zero, output the whole model
+  float * zero = NULL;
+  if( config->survey_width != config->model_width ) {
+    zero = (float*) calloc( config->model_height, sizeof(float) );
+    if( zero == NULL )
+      exit(EXIT_FAILURE);
+  }
+  unsigned x;
+  for( x = 0; x < config->model_x0; x++ )
+    fwrite( zero, sizeof(float), config->model_height, f1 );
+
+  if( ! config->randbound )
+    fwrite( matrice, sizeof(float), (unsigned long)config->height * (unsigned long)config->width * config->depth, f1 );
+  else {
+    // only the model, without the random velocity layer
+    unsigned i;
+    for( i = config->randbound; i < config->randbound + config->model_width; i++ )
+      fwrite( &matrice[ (unsigned long)i * config->height + config->randbound ], sizeof(float), config->model_height, f1 );
+  }
+
+  for( x = config->model_x0 + config->model_width; x < config->survey_width; x++ )
+    fwrite( zero, sizeof(float), config->model_height, f1 );
+  free( zero );
   fclose(f1);
 }
 
@@ -28,9 +117,10 @@ void show_ascii( config_t * config, unsigned scale, float * apf, float * nppf  )
     matrice = apf;
 
   unsigned i, j;
-  for( j = 0; j < config->height; j+=scale ) {
-    for( i = 0; i < config->width; i+=scale ) {
-      unsigned offset = i * config->height + j;
+  for( j = config->randbound; j < config->randbound + config->model_height; j+=scale ) {
+    for( i = config->randbound; i < config->randbound + config->model_width; i+=scale ) {
+      // 3D: the plane of the pulse
+      unsigned long offset = ((unsigned long)i * config->depth + config->pulseZ) * config->height + j;
       if( matrice[ offset ] == 0.0f )
         printf("0");
       else if( matrice[ offset ] > 0.0f )
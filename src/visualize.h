@@ -6,6 +6,8 @@
 
 #include "config.h"
 
+int map_matrices( config_t * config, float ** apf, float ** nppf );
+void unmap_matrices( void );
 void write_matrice( config_t * config, float * apf, float * nppf  );
 void show_ascii( config_t * config, unsigned scale, float * apf, float * nppf  );
 
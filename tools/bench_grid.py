@@ -0,0 +1,148 @@
+# Copyright 2017 - , Dr.-Ing. Patrick Siegl
+# SPDX-License-Identifier: BSD-2-Clause
+
+#!/usr/bin/python
+
+# Grid size regression benchmark:
+#  - small grids: median INNER GFLOPS of every kernel against a baseline
+#    binary (e.g. built from the previous release), fails on a loss larger
+#    than the tolerance.
+#  - --large: a shot at the far end of a grid with more than 2^32 points,
+#    propagated with --track. Its traces have to match the same shot run
+#    with --aperture, which only allocates the columns around the shot.
+#    Needs ~ 3 * 4 * points bytes of memory, hence it is opt-in.
+# seismic-rtm.elf needs (height - 4) in multiples of lanes * threads, the
+# heights below get rounded to the nearest one for --threads.
+
+import argparse
+import multiprocessing
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+SMALL_GRIDS = [ ( 2000, 644 ), ( 500, 260 ) ] # width, height
+LARGE_HEIGHT = 1028
+LANES = 8 # floats per vector of the widest kernel (avx)
+
+
+def grid_height( height, threads ):
+  step = LANES * threads
+  return 4 + max( 1, int( round( (height - 4) / float( step ) ) ) ) * step
+
+
+def get_all_supported( elf ):
+  out = subprocess.check_output( [ elf, "--help" ], shell=False )
+  lines = out.decode("utf-8").splitlines()
+  variants = []
+  it = enumerate(lines)
+  for tpl in it:
+    if "--kernel" in tpl[1]:
+      break
+  for tpl in it:
+    words = tpl[1].split()
+    if words[0].startswith("--"):
+      break
+    # one kernel per line, the others describe the option
+    if len(words) == 1:
+      variants.append(words[0])
+  return variants
+
+
+def gflops( elf, width, height, timesteps, threads, var ):
+  cmd = [ elf, "--timesteps=%d" % timesteps, "--width=%d" % width, "--height=%d" % height,
+          "--pulseX=%d" % (width // 2), "--pulseY=%d" % (height // 8),
+          "--threads=%d" % threads, "--kernel=%s" % var ]
+  out = subprocess.check_output( cmd, shell=False )
+  obj = re.search( r'INNER.*GFLOPS: ([0-9]*\.[0-9]*)', out.decode("utf-8") )
+  return float( obj.group(1) )
+
+
+def median( vals ):
+  vals = sorted(vals)
+  n = len(vals)
+  return vals[ n // 2 ] if n % 2 else (vals[ n // 2 - 1 ] + vals[ n // 2 ]) / 2.0
+
+
+def small( args, variants ):
+  failed = []
+  for width, height in SMALL_GRIDS:
+    height = grid_height( height, args.threads )
+    print("--- %dx%d, %d timesteps, %d threads" % (width, height, args.timesteps, args.threads))
+    for var in variants:
+      cur, base = [], []
+      for t in range(args.iterations):
+        # interleaved, due to throttling and turbo boost
+        cur.append( gflops( args.elf, width, height, args.timesteps, args.threads, var ) )
+        if args.baseline:
+          base.append( gflops( args.baseline, width, height, args.timesteps, args.threads, var ) )
+
+      if not args.baseline:
+        print("%8.2f Gflops: %s" % (median(cur), var))
+        continue
+
+      ratio = median(cur) / median(base)
+      ok = ratio >= 1.0 - args.tolerance
+      print("%8.2f Gflops (baseline %8.2f, %5.2fx) %s: %s" % (median(cur), median(base), ratio, "ok  " if ok else "FAIL", var))
+      if not ok:
+        failed.append( "%s@%dx%d" % (var, width, height) )
+  return failed
+
+
+def large( args, variants ):
+  failed = []
+  height = grid_height( LARGE_HEIGHT, args.threads )
+  width = args.large // height + 1
+  pulse_x = width - 400
+  receivers = "--receivers=%d:%d:5@10" % (pulse_x - 200, pulse_x + 200)
+  print("--- %dx%d (%d points), pulse at x = %d" % (width, height, width * height, pulse_x))
+
+  tmp = tempfile.mkdtemp()
+  for var in variants:
+    traces = []
+    for mode in [ "--aperture=300", "--track" ]:
+      f = os.path.join( tmp, "gather%d.su" % len(traces) )
+      cmd = [ args.elf, "--timesteps=%d" % args.timesteps, "--width=%d" % width, "--height=%d" % height,
+              "--pulseX=%d" % pulse_x, "--pulseY=64", receivers, "--traces=%s" % f,
+              "--threads=%d" % args.threads, "--kernel=%s" % var, mode ]
+      subprocess.check_output( cmd, shell=False )
+      with open( f, "rb" ) as fh:
+        traces.append( fh.read() )
+      os.remove( f )
+
+    ok = traces[0] == traces[1]
+    print("%s: %s" % ("ok  " if ok else "FAIL", var))
+    if not ok:
+      failed.append( "%s@large" % var )
+  os.rmdir( tmp )
+  return failed
+
+
+parser = argparse.ArgumentParser( description="Grid size regression benchmark" )
+parser.add_argument( "kernels", nargs="*", help="kernels to run, default: all 2D kernels" )
+parser.add_argument( "--elf", default="./seismic-rtm.elf" )
+parser.add_argument( "--baseline", help="binary to compare the small grids against" )
+parser.add_argument( "--tolerance", type=float, default=0.05, help="allowed GFLOPS loss, default: 0.05" )
+parser.add_argument( "--iterations", type=int, default=5 )
+parser.add_argument( "--timesteps", type=int, default=1000 )
+parser.add_argument( "--threads", type=int, default=multiprocessing.cpu_count() )
+parser.add_argument( "--large", type=int, nargs="?", const=(1 << 32) + (1 << 20), default=0,
+                     help="number of points of the large grid, default: 2^32 + 2^20" )
+args = parser.parse_args()
+
+variants = get_all_supported( args.elf )
+for v in args.kernels:
+  if v not in variants:
+    print("%s is not supported on this machine!" % v )
+    sys.exit(1)
+if args.kernels:
+  variants = args.kernels
+
+failed = small( args, variants )
+if args.large:
+  failed += large( args, variants )
+
+if failed:
+  print("regressions: %s" % " ".join(failed))
+  sys.exit(1)
@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+/*
+  Microbenchmark of the registered 2D kernels, single-threaded, without
+  running the whole binary: one grid per cache level (half of L1D, L2
+  and LLC, then well beyond the LLC) for the working set of apf, nppf and
+  vel. The inner points of a column are a multiple of 16 floats (aligned
+  to cache lines) or one vector of the kernel more (misaligned), the
+  smallest height the kernel still accepts.
+
+    seismic-micro.elf
+    seismic-micro.elf -m 256 avx_unaligned sse_std
+
+  Each kernel runs enough timesteps for 4M grid points per measurement,
+  the best of MICRO_REPS counts. Reported are ns per grid point and
+  timestep and the bandwidth of KERNEL_BYTES per point.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "kernel.h"
+#include "seismic.h"
+
+#define MICRO_REPS      3
+#define MICRO_POINTS    (4ul << 20) // per measurement
+#define MICRO_MISALIGN  16 // floats, at most one vector more
+
+extern unsigned sym_kern_c;
+extern sym_kernel_t* sym_kern[];
+
+typedef struct _micro_grid_t micro_grid_t;
+struct _micro_grid_t {
+  const char * level;
+  unsigned long ws; // bytes, apf, nppf and vel
+};
+
+static double now( void ) {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long cache_size( int name, unsigned long fallback ) {
+  long v = sysconf( name );
+  return v > 0 ? (unsigned long)v : fallback;
+}
+
+// height of 16k + 4 floats, width for the working set
+static void grid_dims( unsigned long ws, unsigned * width, unsigned * height ) {
+  unsigned long points = ws / (3 * sizeof(float));
+  unsigned long h = (unsigned long)sqrt( (double)points );
+  h = (h / 16 ? h / 16 : 1) * 16 + 4;
+  *height = h;
+  *width = points / h > 8 ? points / h : 8;
+}
+
+static void print_usage( const char * argv0 ) {
+  printf("\n"
+         "usage: %s [-m <MB>] [<kernel> ...]\n"
+         "\n"
+         "  -m     \t working set beyond the LLC, default: 4 * LLC, at most 1024 MB\n"
+         "  kernel \t the kernels to measure, default: all 2D ones of this machine\n", argv0 );
+}
+
+int main( int argc, char * argv[] ) {
+  unsigned long dram_mb = 1024;
+  int a = 1;
+  if( a + 1 < argc && ! strcmp( argv[a], "-m" ) ) {
+    dram_mb = strtoul( argv[a + 1], NULL, 10 );
+    a += 2;
+  }
+  if( a < argc && argv[a][0] == '-' ) {
+    print_usage( argv[0] );
+    exit(strcmp( argv[a], "-h" ) ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+  // the selected kernels, all 2D ones the machine supports by default
+  archfeatures cap = check_hw_capabilites();
+  sym_kernel_t * kern[ 32 ];
+  unsigned kern_c = 0, i, k;
+  for( i = 0; i < sym_kern_c; i++ ) {
+    int wanted = a == argc;
+    for( k = a; ! wanted && k < (unsigned)argc; k++ )
+      wanted = ! strcmp( argv[k], sym_kern[i]->name );
+    if( wanted && sym_kern[i]->dims == 2 && ! (sym_kern[i]->cap.bits & ~cap.bits) )
+      kern[ kern_c++ ] = sym_kern[i];
+  }
+  if( ! kern_c || (a < argc && kern_c != (unsigned)(argc - a)) ) {
+    fprintf(stderr, "ERROR: unknown or unsupported kernel (2D only), see seismic-rtm.elf --help\n");
+    exit(EXIT_FAILURE);
+  }
+
+  unsigned long l1 = cache_size( _SC_LEVEL1_DCACHE_SIZE, 32ul << 10 );
+  unsigned long l2 = cache_size( _SC_LEVEL2_CACHE_SIZE, 1ul << 20 );
+  unsigned long llc = cache_size( _SC_LEVEL3_CACHE_SIZE, 4 * l2 );
+  unsigned long dram = 4 * llc > (64ul << 20) ? 4 * llc : (64ul << 20);
+  if( dram > (dram_mb << 20) )
+    dram = dram_mb << 20;
+  micro_grid_t grids[] = { { "L1", l1 / 2 }, { "L2", l2 / 2 }, { "LLC", llc / 2 }, { "DRAM", dram } };
+  unsigned grid_c = sizeof(grids) / sizeof(grids[0]), g, m;
+
+  unsigned alignment = 0;
+  for( k = 0; k < kern_c; k++ )
+    if( kern[k]->alignment > alignment )
+      alignment = kern[k]->alignment;
+
+  printf("L1D %lu KB, L2 %lu KB, LLC %lu KB; %u kernels, best of %u\n\n", l1 >> 10, l2 >> 10, llc >> 10, kern_c, MICRO_REPS);
+  printf("%-32s %-5s %-10s %13s %10s %10s %10s\n", "kernel", "level", "columns", "grid", "ws KB", "ns/pt", "GB/s");
+
+  // the kernels print their progress
+  int out = dup( STDOUT_FILENO ), null = open( "/dev/null", O_WRONLY );
+  if( out < 0 || null < 0 ) {
+    fprintf(stderr, "ERROR: could not open /dev/null\n");
+    exit(EXIT_FAILURE);
+  }
+
+  BARRIER_TYPE barrier;
+  BARRIER_INIT( &barrier, 1 );
+
+  for( g = 0; g < grid_c; g++ ) {
+    unsigned width, aligned;
+    grid_dims( grids[g].ws, &width, &aligned );
+    unsigned long size = (unsigned long)width * (aligned + MICRO_MISALIGN);
+    unsigned steps = MICRO_POINTS / size ? MICRO_POINTS / size : 1;
+
+    // zero wavefields without pulse, each height fits into the buffers
+    float *APF, *NPPF, *VEL, *pulsevector;
+    if( alloc_seismic_buffers( width, aligned + MICRO_MISALIGN, steps, alignment, &VEL, &APF, &NPPF, &pulsevector ) ) {
+      printf("allocation failure\n");
+      exit(EXIT_FAILURE);
+    }
+    float h = SEISMIC_H, dt = SEISMIC_DT, c = (SEISMIC_C_MAX - SEISMIC_C_MIN) / 2 + SEISMIC_C_MIN;
+    init_seismic_matrices( width, aligned + MICRO_MISALIGN, VEL, APF, NPPF, (c*c*dt*dt)/(h*h*12.0f), 0 );
+    memset( pulsevector, 0, (steps + 1) * sizeof(float) );
+
+    for( m = 0; m < 2; m++ ) {
+      for( k = 0; k < kern_c; k++ ) {
+        sym_kernel_t * v = kern[k];
+        unsigned height = aligned + (m ? v->vectorwidth / sizeof(float) : 0);
+        unsigned long points = (unsigned long)(width - 4) * (height - 4);
+        printf("%-32s %-5s %-10s %6ux%-6u %10lu ", v->name, grids[g].level, m ? "misaligned" : "aligned",
+               width, height, (unsigned long)width * height * 3 * sizeof(float) >> 10);
+        if( height - aligned > MICRO_MISALIGN ) {
+          printf("%10s %10s\n", "-", "-");
+          continue;
+        }
+
+        // like seismic_setup() for a single thread
+        stack_t data;
+        memset( &data, 0, sizeof(data) );
+        data.barrier = &barrier;
+        data.vel = VEL;
+        data.pulsevector = pulsevector;
+        data.width = width;
+        data.height = height;
+        data.timesteps = steps;
+        data.x_pulse = width / 2;
+        data.y_pulse = height / 2;
+        data.depth = 1;
+        data.z_end = data.z_block = 1;
+        data.y_offset = v->alignment ? v->alignment / sizeof(float) : 1;
+        data.x_start = data.strip_x_start = 2;
+        data.x_end = data.strip_x_end = width - 2;
+        data.y_start = 2;
+        data.y_end = height - 2;
+        data.set_pulse = 1;
+
+        double best = 0.0;
+        unsigned r;
+        for( r = 0; r < MICRO_REPS; r++ ) {
+          data.apf = APF;
+          data.nppf = NPPF;
+          data.step = 0;
+          fflush( stdout );
+          dup2( null, STDOUT_FILENO );
+          double t = now();
+          v->fnc_sgl( &data );
+          t = now() - t;
+          fflush( stdout );
+          dup2( out, STDOUT_FILENO );
+          if( ! r || t < best )
+            best = t;
+        }
+        double ns = best * 1e9 / ((double)points * steps);
+        printf("%10.3f %10.2f\n", ns, v->bytes / ns);
+        fflush( stdout );
+      }
+    }
+
+    unsigned offset = alignment ? (alignment - 2 * sizeof(float)) : 0;
+    free( ((char*)APF) - offset );
+    free( ((char*)NPPF) - offset );
+    free( ((char*)VEL) - offset );
+    free( pulsevector );
+  }
+
+  close( null );
+  close( out );
+  return 0;
+}
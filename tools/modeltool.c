@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+/*
+  Writes a layered velocity model (m/s) for --velocity, one column of
+  height values per x: the layers have equal thickness and dip by one row
+  every 8 columns, so that neighbouring strips see different columns.
+  The format follows the file name like for --velocity, SEG-Y in IEEE
+  floats or, with -i, in IBM floats.
+
+    seismic-model.elf 1000 516 800,1100,1400 velocity.bin
+    seismic-model.elf -i 1000 516 800,1100,1400 velocity_ibm.sgy
+
+  Whole velocities are exact in all formats, hence all of them give the
+  same wavefield. The timestep is fixed (SEISMIC_DT) by c_max, hence
+  seismic-rtm.elf rejects models beyond 2000 m/s.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define TRACE_HEADER      240
+#define SEGY_TEXT_HEADER  3200
+#define SEGY_BIN_HEADER   400
+#define MODEL_LAYERS      16
+#define MODEL_DIP         8 // columns per row
+
+static void put16be( unsigned char * p, unsigned v ) {
+  p[0] = v >> 8;
+  p[1] = v;
+}
+
+static void put32be( unsigned char * p, uint32_t v ) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+// 0.frac * 16^(exp - 64), truncated
+static uint32_t ieee2ibm( float f ) {
+  if( f == 0.0f )
+    return 0;
+  int e;
+  double m = frexp( fabs( f ), &e ); // [0.5, 1) * 2^e
+  int e16 = (e + 3 + 256) / 4 - 64; // ceil( e / 4 )
+  uint32_t frac = (uint32_t)ldexp( m, 24 + e - 4 * e16 );
+  return (f < 0.0f ? 0x80000000u : 0) | ((uint32_t)(e16 + 64) << 24) | frac;
+}
+
+static int has_ext( const char * file, const char * ext ) {
+  const char * e = strrchr( file, '.' );
+  return e && ! strcmp( e, ext );
+}
+
+static void print_usage( const char * argv0 ) {
+  printf("\n"
+         "usage: %s [-i] <width> <height> <v0,v1,...> <out>\n"
+         "\n"
+         "  -i     \t IBM instead of IEEE floats (SEG-Y)\n"
+         "  v0,v1 \t velocities of the layers top down, m/s\n"
+         "  out    \t *.sgy, *.segy: SEG-Y, otherwise raw float32\n", argv0 );
+}
+
+int main( int argc, char * argv[] ) {
+  int a = 1, ibm = 0;
+  if( a < argc && ! strcmp( argv[a], "-i" ) ) {
+    ibm = 1;
+    a++;
+  }
+  if( argc - a != 4 ) {
+    print_usage( argv[0] );
+    exit(EXIT_FAILURE);
+  }
+
+  unsigned width = strtoul( argv[a], NULL, 10 ), height = strtoul( argv[a + 1], NULL, 10 );
+  float vel[ MODEL_LAYERS ];
+  unsigned layers = 0;
+  char * p = argv[a + 2];
+  while( layers < MODEL_LAYERS && *p ) {
+    vel[ layers++ ] = strtof( p, &p );
+    if( *p == ',' )
+      p++;
+  }
+  const char * file = argv[a + 3];
+  int segy = has_ext( file, ".sgy" ) || has_ext( file, ".segy" );
+  if( ! width || ! height || height > 0xffff || ! layers || *p ) {
+    fprintf(stderr, "ERROR: invalid model, at most %u layers and 65535 rows\n", MODEL_LAYERS);
+    exit(EXIT_FAILURE);
+  }
+
+  FILE * f = fopen( file, "wb" );
+  float * col = (float*) malloc( height * sizeof(float) );
+  if( f == NULL || col == NULL ) {
+    fprintf(stderr, "ERROR: could not create '%s'\n", file);
+    exit(EXIT_FAILURE);
+  }
+
+  if( segy ) {
+    unsigned char text[ SEGY_TEXT_HEADER ], bin[ SEGY_BIN_HEADER ];
+    memset( text, ' ', sizeof(text) );
+    memset( bin, 0, sizeof(bin) );
+
+    char line[81];
+    snprintf( line, sizeof(line), "C 1 SEISMIC-RTM LAYERED VELOCITY MODEL, %u LAYERS, M/S", layers );
+    memcpy( &text[ 0 ], line, strlen( line ) );
+    memcpy( &text[ 39 * 80 ], "C40 END TEXTUAL HEADER", 22 );
+
+    put16be( &bin[ 20 ], height );
+    put16be( &bin[ 24 ], ibm ? 1 : 5 );
+    put16be( &bin[ 54 ], 1 ); // meters
+    bin[ 300 ] = 2; // revision 2.0
+    put16be( &bin[ 302 ], 1 ); // fixed trace length
+
+    fwrite( text, 1, sizeof(text), f );
+    fwrite( bin, 1, sizeof(bin), f );
+  }
+
+  unsigned x, y;
+  for( x = 0; x < width; x++ ) {
+    for( y = 0; y < height; y++ ) {
+      // the boundaries rise to the right
+      long d = (long)y * layers + (long)x * layers / MODEL_DIP - (long)width * layers / (2 * MODEL_DIP);
+      long l = d < 0 ? 0 : d / height;
+      col[ y ] = vel[ l < layers ? l : layers - 1 ];
+    }
+
+    if( segy ) {
+      unsigned char hdr[ TRACE_HEADER ];
+      memset( hdr, 0, sizeof(hdr) );
+      put32be( &hdr[ 0 ], x + 1 ); // tracl
+      put32be( &hdr[ 4 ], x + 1 ); // tracr
+      put32be( &hdr[ 20 ], x + 1 ); // cdp
+      put16be( &hdr[ 28 ], 1 ); // trid
+      put16be( &hdr[ 114 ], height );
+      fwrite( hdr, 1, sizeof(hdr), f );
+
+      for( y = 0; y < height; y++ ) {
+        uint32_t u;
+        memcpy( &u, &col[ y ], sizeof(u) );
+        put32be( (unsigned char*) &col[ y ], ibm ? ieee2ibm( col[ y ] ) : u );
+      }
+    }
+    fwrite( col, sizeof(float), height, f );
+  }
+
+  free( col );
+  if( fclose( f ) ) {
+    fprintf(stderr, "ERROR: could not write '%s'\n", file);
+    exit(EXIT_FAILURE);
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+# Copyright 2017 - , Dr.-Ing. Patrick Siegl
+# SPDX-License-Identifier: BSD-2-Clause
+
+#!/usr/bin/python
+
+# Scaling study of one kernel over 1 .. N threads, one --bench run each:
+#  - strong: the same grid for every thread count,
+#  - weak: the inner columns grow with the threads, i.e. each thread keeps
+#    the strip of the single-threaded run.
+# Efficiency is GFLOPS(t) / (t * GFLOPS(1)) of the same mode, which is
+# T(1) / (t * T(t)) for strong and T(1) / T(t) for weak scaling. The
+# pinning is the one reported by seismic-rtm.elf.
+# seismic-rtm.elf needs (height - 4) in multiples of lanes * threads: the
+# height gets rounded to the nearest one per thread count, by default
+# only thread counts that fit the given height are run.
+
+import argparse
+import json
+import multiprocessing
+import os
+import subprocess
+import sys
+import tempfile
+
+COLUMNS = [ "mode", "kernel", "threads", "width", "height", "points", "pinning", "cores",
+            "step_ms", "time_s", "gflops", "gbs", "speedup", "efficiency" ]
+
+
+def grid_height( args, threads ):
+  step = args.lanes * threads
+  return 4 + max( 1, int( round( (args.height - 4) / float( step ) ) ) ) * step
+
+
+def bench( args, threads, width, height, report ):
+  cmd = [ args.elf, "--timesteps=%d" % args.timesteps, "--width=%d" % width, "--height=%d" % height,
+          "--pulseX=%d" % (width // 2), "--pulseY=%d" % (height // 8),
+          "--threads=%d" % threads, "--kernel=%s" % args.kernel, "--quite",
+          "--bench=%d" % args.iterations, "--report=%s" % report ]
+  subprocess.check_output( cmd, shell=False )
+  with open( report ) as f:
+    return json.load( f )
+
+
+def sweep( args, mode, report ):
+  rows = []
+  for t in args.threads:
+    # weak: (width - 4) / t inner columns per thread stay the same
+    width = args.width if mode == "strong" else 4 + (args.width - 4) * t
+    height = grid_height( args, t )
+    if height != args.height:
+      print("%-6s %3d threads: height %d instead of %d" % (mode, t, height, args.height))
+    res = bench( args, t, width, height, report )
+    k = res[ "kernels" ][ 0 ]
+    step_ms = k[ "step_ms" ][ "median" ]
+    rows.append( { "mode": mode, "kernel": args.kernel, "threads": t, "width": width, "height": height,
+                   "points": (width - 4) * (height - 4), "pinning": res[ "grid" ][ "pinning" ],
+                   "cores": res[ "cpu" ][ "cores" ], "step_ms": step_ms,
+                   "time_s": step_ms * args.timesteps / 1000.0,
+                   "gflops": k[ "gflops" ][ "median" ], "gbs": k[ "gbs" ][ "median" ] } )
+
+  base = rows[ 0 ]
+  for r in rows:
+    r[ "speedup" ] = r[ "gflops" ] / base[ "gflops" ] * base[ "threads" ]
+    r[ "efficiency" ] = r[ "speedup" ] / r[ "threads" ]
+    print("%-6s %3d threads %6dx%-5d %10.3f ms/step %8.2f Gflops %8.2f GB/s %6.2fx %6.1f%%  %s"
+          % (mode, r[ "threads" ], r[ "width" ], r[ "height" ], r[ "step_ms" ], r[ "gflops" ], r[ "gbs" ],
+             r[ "speedup" ], 100.0 * r[ "efficiency" ], r[ "pinning" ]))
+  return rows
+
+
+def thread_list( s ):
+  return [ int(t) for t in s.split(",") ]
+
+
+parser = argparse.ArgumentParser( description="Strong and weak scaling study of one kernel" )
+parser.add_argument( "kernel", help="kernel to run, see seismic-rtm.elf --help" )
+parser.add_argument( "--elf", default="./seismic-rtm.elf" )
+parser.add_argument( "--mode", choices=[ "strong", "weak", "both" ], default="both" )
+parser.add_argument( "--threads", type=thread_list,
+                     help="comma separated thread counts, default: those of 1 .. number of cores that fit the height" )
+parser.add_argument( "--width", type=int, default=2000, help="width of the strong runs and per thread of the weak runs" )
+parser.add_argument( "--height", type=int, default=644 )
+parser.add_argument( "--timesteps", type=int, default=500 )
+parser.add_argument( "--lanes", type=int, default=8, help="floats per vector of the kernel, default: 8 (avx)" )
+parser.add_argument( "--iterations", type=int, default=3, help="repetitions per run (--bench), default: 3" )
+parser.add_argument( "--csv", default="scaling.csv" )
+args = parser.parse_args()
+
+if args.threads is None:
+  args.threads = [ t for t in range( 1, multiprocessing.cpu_count() + 1 ) if grid_height( args, t ) == args.height ] or [ 1 ]
+
+if sorted(args.threads) != args.threads or args.threads[0] < 1:
+  print("thread counts have to be ascending and positive!")
+  sys.exit(1)
+
+fd, report = tempfile.mkstemp( suffix=".json" )
+os.close( fd )
+rows = []
+try:
+  for mode in ( [ "strong", "weak" ] if args.mode == "both" else [ args.mode ] ):
+    rows += sweep( args, mode, report )
+finally:
+  os.remove( report )
+
+with open( args.csv, "w" ) as f:
+  f.write( ",".join( COLUMNS ) + "\n" )
+  for r in rows:
+    f.write( ",".join( ("%.6f" % r[ c ]) if isinstance( r[ c ], float ) else str( r[ c ] ) for c in COLUMNS ) + "\n" )
+print("written to %s" % args.csv)
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+/*
+  Consumer of the shared-memory ring of a running propagation (--shm):
+  follows the frames as they are published, or extracts one of the frames
+  still in the ring as raw float32, or removes the ring.
+
+    seismic-shm.elf /seismic-rtm
+    seismic-shm.elf /seismic-rtm -1 last.bin
+    seismic-shm.elf /seismic-rtm -u
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+#include "shmring.h"
+
+static void print_usage( const char * argv0 ) {
+  printf("\n"
+         "usage: %s <name> [<frame> <out|-> | -u]\n"
+         "\n"
+         "  without frame, show every frame published from now on\n"
+         "  frame \t number of the frame, -1: the last one\n"
+         "  out   \t raw float32 file, '-': stdout\n"
+         "  -u    \t remove the shared memory\n", argv0 );
+}
+
+int main( int argc, char * argv[] ) {
+  if( argc != 2 && !(argc == 3 && ! strcmp( argv[2], "-u" )) && argc != 4 ) {
+    print_usage( argv[0] );
+    exit(EXIT_FAILURE);
+  }
+
+  if( argc == 3 ) {
+    if( shm_unlink( argv[1] ) ) {
+      fprintf(stderr, "ERROR: could not remove '%s'\n", argv[1]);
+      exit(EXIT_FAILURE);
+    }
+    return 0;
+  }
+
+  shmring_t * ring = shmring_open( argv[1] );
+  if( ring == NULL ) {
+    fprintf(stderr, "ERROR: '%s' is no shared-memory ring\n", argv[1]);
+    exit(EXIT_FAILURE);
+  }
+  const shmring_header_t * hdr = ring->hdr;
+  unsigned long len = (unsigned long)hdr->width * hdr->height;
+
+  if( argc == 4 ) {
+    int frame = atoi( argv[2] );
+    if( frame < 0 )
+      frame += __atomic_load_n( &hdr->published, __ATOMIC_ACQUIRE );
+
+    FILE * f = strcmp( argv[3], "-" ) ? fopen( argv[3], "wb" ) : stdout;
+    if( f == NULL ) {
+      fprintf(stderr, "ERROR: could not create '%s'\n", argv[3]);
+      exit(EXIT_FAILURE);
+    }
+
+    // straight from the ring, checked afterwards
+    const float * src = frame >= 0 ? shmring_frame( ring, frame ) : NULL;
+    if( src == NULL || fwrite( src, sizeof(float), len, f ) != len || ! shmring_valid( ring, frame ) ) {
+      fprintf(stderr, "ERROR: frame %s is not in the ring (any more)\n", argv[2]);
+      exit(EXIT_FAILURE);
+    }
+
+    if( f != stdout )
+      fclose( f );
+    shmring_detach( ring );
+    return 0;
+  }
+
+  printf("%ux%u, every %u timesteps, %u frames in %u slots\n", hdr->width, hdr->height, hdr->every, hdr->frames, hdr->slots);
+  unsigned seen = __atomic_load_n( &hdr->published, __ATOMIC_ACQUIRE ), read = 0, skipped = 0;
+  while( seen < hdr->frames ) {
+    unsigned published = shmring_wait( ring, seen, 100 );
+    if( published == seen ) {
+      if( __atomic_load_n( &hdr->done, __ATOMIC_ACQUIRE ) )
+        break;
+      continue;
+    }
+
+    // the oldest ones may be overwritten already
+    unsigned n;
+    for( n = seen; n < published; n++ ) {
+      const float * src = shmring_frame( ring, n );
+      float max = 0.0f;
+      unsigned long i;
+      for( i = 0; src != NULL && i < len; i++ )
+        if( fabsf( src[ i ] ) > max )
+          max = fabsf( src[ i ] );
+
+      if( src == NULL || ! shmring_valid( ring, n ) ) {
+        skipped++;
+        continue;
+      }
+      read++;
+      printf("frame %u (timestep %u): max |p| = %e\n", n, (n + 1) * hdr->every, max);
+    }
+    seen = published;
+  }
+  printf("%u frames read, %u skipped\n", read, skipped);
+
+  shmring_detach( ring );
+  return 0;
+}
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// SPDX-FileCopyrightText: 2017 Dr.-Ing. Patrick Siegl <patrick@siegl.it>
+
+/*
+  Inspects snapshot containers (*.snap) and extracts frames or windows of
+  them as raw float32, column by column, e.g. for ximage:
+
+    seismic-snap.elf movie.snap
+    seismic-snap.elf movie.snap 12 - 100:400 0:300 | ximage n1=300
+
+  With -r, a raw movie (--movie=*.bin) of frames of the given grid.
+
+    seismic-snap.elf -r 1064x580 movie.bin -1 last.bin
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapfile.h"
+
+static void print_usage( const char * argv0 ) {
+  printf("\n"
+         "usage: %s [-r <width>x<height>] <file.snap> [<frame> <out|-> [<x0:x1> [<y0:y1>]]]\n"
+         "\n"
+         "  -r    \t raw frames of the grid instead of a container\n"
+         "  without frame, show the header of the container\n"
+         "  frame \t number of the frame, -1: the last one\n"
+         "  out   \t raw float32 file, '-': stdout\n"
+         "  x0:x1 \t columns, default: all\n"
+         "  y0:y1 \t rows, default: all\n", argv0 );
+}
+
+int main( int argc, char * argv[] ) {
+  unsigned raw_width = 0, raw_height = 0;
+  if( argc > 2 && ! strcmp( argv[1], "-r" ) ) {
+    if( sscanf( argv[2], "%ux%u", &raw_width, &raw_height ) != 2 ) {
+      print_usage( argv[0] );
+      exit(EXIT_FAILURE);
+    }
+    argv[2] = argv[0];
+    argv += 2;
+    argc -= 2;
+  }
+  if( argc < 2 || argc == 3 || argc > 6 ) {
+    print_usage( argv[0] );
+    exit(EXIT_FAILURE);
+  }
+
+  snapfile_t * s = raw_width ? snapfile_open_raw( argv[1], raw_width, raw_height ) : snapfile_open( argv[1] );
+  if( s == NULL ) {
+    if( raw_width )
+      fprintf(stderr, "ERROR: '%s' holds no frame of %ux%u\n", argv[1], raw_width, raw_height);
+    else
+      fprintf(stderr, "ERROR: '%s' is no snapshot container\n", argv[1]);
+    exit(EXIT_FAILURE);
+  }
+  const snapfile_header_t * hdr = s->hdr;
+
+  if( argc == 2 ) {
+    printf("grid   = %ux%u (x%u)\n"
+           "frames = %u, every %u timesteps\n"
+           "chunks = %u of %u columns per frame\n"
+           "kernel = %s, order %u\n"
+           "dt     = %e s, h = %f m\n"
+           "bound  = %u (random), model from column %u\n",
+           hdr->width, hdr->height, hdr->depth, hdr->frames, hdr->every,
+           hdr->chunks, hdr->chunk_cols, hdr->kernel, hdr->order,
+           hdr->dt, hdr->h, hdr->randbound, hdr->model_x0 );
+    snapfile_close( s );
+    return 0;
+  }
+
+  int frame = atoi( argv[2] );
+  if( frame < 0 )
+    frame += hdr->frames;
+  unsigned x0 = 0, x1 = hdr->width, y0 = 0, y1 = hdr->height;
+  if( (argc > 4 && sscanf( argv[4], "%u:%u", &x0, &x1 ) != 2)
+      || (argc > 5 && sscanf( argv[5], "%u:%u", &y0, &y1 ) != 2) ) {
+    print_usage( argv[0] );
+    exit(EXIT_FAILURE);
+  }
+
+  if( frame < 0 || (unsigned) frame >= hdr->frames ) {
+    fprintf(stderr, "ERROR: no frame %s, %u frames\n", argv[2], hdr->frames);
+    exit(EXIT_FAILURE);
+  }
+
+  float * win = (float*) malloc( (unsigned long)(y1 > y0 ? y1 - y0 : 1) * sizeof(float) );
+  if( win == NULL ) {
+    printf("allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+
+  FILE * f = strcmp( argv[3], "-" ) ? fopen( argv[3], "wb" ) : stdout;
+  if( f == NULL ) {
+    fprintf(stderr, "ERROR: could not create '%s'\n", argv[3]);
+    exit(EXIT_FAILURE);
+  }
+
+  // a column at a time, only its pages are read
+  unsigned x;
+  for( x = x0; x < x1; x++ ) {
+    if( snapfile_window( s, frame, x, x + 1, y0, y1, win ) ) {
+      fprintf(stderr, "ERROR: frame %d has no window %u:%u %u:%u\n", frame, x0, x1, y0, y1);
+      exit(EXIT_FAILURE);
+    }
+    fwrite( win, sizeof(float), y1 - y0, f );
+  }
+
+  if( f != stdout )
+    fclose( f );
+  free( win );
+  snapfile_close( s );
+  return 0;
+}